@@ -0,0 +1,768 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "src/core.h"
+#include <stddef.h>
+#include <string.h>
+
+#define TWO_PI (2 * BTEDB_KICK_PI)
+
+// Partials whose peak contribution over a block falls below this level (about -100dB) aren't rendered.
+#define PARTIAL_CULL_LEVEL 1e-5f
+
+// Overtones fade out linearly over this fraction of the band below Nyquist, rather than switching off at it, so that
+// one swept across it doesn't click.
+#define NYQUIST_FADE 0.1f
+
+// Samples rendered per pass. Per-sample values that depend on the previous sample (phase and noise) are
+// worked out for a pass first, so that everything else runs in plain loops over the pass that vectorize.
+#define PASS_FRAMES 64
+
+// A voice whose output can't rise above this level again (about -100dB) until the next note isn't rendered.
+#define IDLE_LEVEL 1e-5f
+
+// The sweep and envelopes are evaluated every few samples, at most this many, and interpolated between. They may
+// stray from their exact values by this much of their range in between (about -80dB).
+#define ENVELOPE_DECIMATION_MAX 16
+#define ENVELOPE_ERROR 1e-4f
+
+// Pink noise is generated at the lowest rate, by halving the output rate, that's still at least this.
+#define NOISE_RATE_MIN 44100
+
+static const uint32_t lcg_multiplier = 1103515245;
+static const uint32_t lcg_increment = 12345;
+
+// A generator state as a float between -1.0 and 1.0.
+static inline float lcg_float(uint32_t state) {
+  // Hexadecimal floating point literals are a means to define constant real values that can be exactly
+  // represented as a floating point value.
+  //
+  // https://www.pcg-random.org/posts/bounded-rands.html
+  // https://www.exploringbinary.com/hexadecimal-floating-point-constants/
+  // pg 57-58: http://www.open-std.org/jtc1/sc22/wg14/www/docs/n1256.pdf
+  return -1.0f + 0x2.0p-32 * state;
+}
+
+// Advance a generator state and return it as a float between -1.0 and 1.0.
+// https://www.pcg-random.org/pdf/hmc-cs-2014-0905.pdf
+static inline float lcg(uint32_t* state) {
+  *state = (*state + lcg_increment) * lcg_multiplier;
+  return lcg_float(*state);
+}
+
+// The state lcg would reach after 'steps' calls, in log(steps) time.
+//
+// Each step is the affine map x -> a*x + b, mod 2^32. Composing the map for each set bit of 'steps' with itself
+// squared at each bit position gives the whole jump. F. Brown, "Random Number Generation with Arbitrary Strides".
+static uint32_t lcg_skip(uint32_t state, uint64_t steps) {
+  uint32_t jump_mul = 1;
+  uint32_t jump_add = 0;
+  uint32_t step_mul = lcg_multiplier;
+  uint32_t step_add = lcg_increment * lcg_multiplier;
+
+  for (; steps; steps >>= 1) {
+    if (steps & 1) {
+      jump_mul *= step_mul;
+      jump_add = jump_add * step_mul + step_add;
+    }
+    step_add = (step_mul + 1) * step_add;
+    step_mul *= step_mul;
+  }
+
+  return jump_mul * state + jump_add;
+}
+
+static inline float lerp(float a, float b, float alpha) {
+  return a + (b-a) * fmaxf(fminf(alpha,1),0);
+}
+
+// Wrap a phase into [0, 2pi). Unlike fmod, this vectorizes.
+static inline float wrap_phase(float phase) {
+  return phase - (float)TWO_PI * floorf(phase * (float)(1 / TWO_PI));
+}
+
+// Time since the note-on of the next sample to be rendered.
+static inline double note_time(const BtEdbKickState* const self, unsigned rate) {
+  return (double)self->frames / rate + self->frame_offset;
+}
+
+// Index of the first sample at or after the given note time, counting from the one at note time 'frame_offset'.
+static inline uint64_t frame_at(double time, double frame_offset, unsigned rate) {
+  const double frame = ceil((time - frame_offset) * rate);
+  return frame > 0 ? (uint64_t)frame : 0;
+}
+
+// True if the voice can't be heard again until the next note.
+//
+// Envelopes only settle into a plain exponential decay after their time parameter has passed, so the voice isn't
+// considered idle before then. After that, their current values bound the rest of the note.
+static int is_idle(const BtEdbKickParams* const p, float seconds, unsigned retrig_count) {
+  if (retrig_count > 0 ||
+      seconds < p->c_amp_time ||
+      seconds < p->c_overtone_vol_time ||
+      seconds < p->c_noise_time)
+    return 0;
+
+  // Pink noise is normalized by the octave count, but can reach twice that before normalization.
+  const float level =
+    (btedb_kick_amp(p, seconds) *
+     (fabsf(p->fundamental_vol) + p->c_overtone_vols_sum * btedb_kick_overtone_env(p, seconds)) +
+     btedb_kick_noise_env(p, seconds) * p->noise_vol * 2) * p->volume;
+
+  return level < IDLE_LEVEL;
+}
+
+// The shortest time constant an envelope shape decays at. It blends from a^power to b^power over the shape's time
+// parameter, and while it's changing, the decay is quicker again by the rate it changes at.
+static inline float shape_tau_min(float a, float b, float power) {
+  const float tau = powf(fminf(a, b), power);
+  const float change = power * fabsf(b - a) * fmaxf(powf(a, power - 1), powf(b, power - 1));
+  return tau / (1 + change / tau);
+}
+
+// Samples between evaluations of an envelope, for the longest spacing in seconds that keeps it within
+// ENVELOPE_ERROR: the largest power of two that fits.
+static inline unsigned envelope_decimation(const BtEdbKickState* self, float spacing, unsigned rate) {
+  if (self->full_rate)
+    return 1;
+  
+  unsigned decimation = 1;
+  while (decimation < ENVELOPE_DECIMATION_MAX && decimation * 2 <= spacing * rate)
+    decimation *= 2;
+  return decimation;
+}
+
+// Interpolating exp(-t/tau) linearly between points h seconds apart strays from it by at most h^2 / (8 tau^2) of
+// its range.
+static inline float shape_spacing(float a, float b, float power) {
+  return shape_tau_min(a, b, power) * sqrtf(8 * ENVELOPE_ERROR);
+}
+
+// The sweep's phase matters as well as its frequency. Since the decay curves one way only, the interpolated sweep
+// is always a little sharp, and over the whole sweep across 'sweep' Hz its phase gets ahead by
+// 2pi * sweep * h^2 / (12 tau) radians.
+static inline float sweep_spacing(const BtEdbKickParams* const p, float sweep) {
+  const float tau = shape_tau_min(p->c_tone_shape_a, p->c_tone_shape_b, p->c_tone_shape_exp);
+  return fminf(tau * sqrtf(8 * ENVELOPE_ERROR), sqrtf(12 * tau * ENVELOPE_ERROR / ((float)TWO_PI * sweep)));
+}
+
+// Samples between updates of the pink noise generator.
+static inline unsigned noise_decimation(unsigned rate) {
+  unsigned decimation = 1;
+  while (rate / (decimation * 2) >= NOISE_RATE_MIN)
+    decimation *= 2;
+  return decimation;
+}
+
+// Evaluate an envelope for the 'n' samples of a pass starting 'start' seconds in. It's evaluated every 'decimation'
+// samples and on the sample after the last, and interpolated linearly between.
+static inline void envelope_pass(
+  float* out, unsigned n, unsigned decimation, float start, float timedelta,
+  float from, float to, float a, float b, float decay_time, float power
+) {
+  if (decimation == 1) {
+    for (unsigned i = 0; i < n; ++i)
+      out[i] = btedb_kick_decay(start + i * timedelta, from, to, a, b, decay_time, power);
+    return;
+  }
+
+  const unsigned points = (n + decimation - 1) / decimation + 1;
+  float values[PASS_FRAMES / 2 + 1];
+  for (unsigned k = 0; k < points; ++k) {
+    const unsigned frame = k * decimation < n ? k * decimation : n;
+    values[k] = btedb_kick_decay(start + frame * timedelta, from, to, a, b, decay_time, power);
+  }
+
+  for (unsigned first = 0, k = 0; first < n; first += decimation, ++k) {
+    const unsigned len = n - first < decimation ? n - first : decimation;
+    const float step = (values[k+1] - values[k]) / len;
+    for (unsigned i = 0; i < len; ++i)
+      out[first + i] = values[k] + step * i;
+  }
+}
+
+// Settings that are compiled to a coefficient of their own, as: coef = scale * base^(setting * exp_scale).
+typedef struct {
+  size_t setting;
+  size_t coef;
+  float scale;
+  float base;
+  float exp_scale;
+} CoefMapping;
+
+#define COEF_MAPPING(name, scale, base, exp_scale) \
+  { offsetof(BtEdbKickParams, name), offsetof(BtEdbKickParams, c_##name), scale, base, exp_scale }
+
+static const CoefMapping coef_mappings[] = {
+  COEF_MAPPING(tone_start, 1, 2, 14.5f),
+  COEF_MAPPING(tone_shape_a, 0.01f, 10, 3),
+  COEF_MAPPING(tone_shape_b, 0.01f, 10, 3),
+  COEF_MAPPING(tone_time, 0.001f, 10, 4),
+  COEF_MAPPING(tone_shape_exp, 0.01f, 10, 3),
+  COEF_MAPPING(amp_shape_a, 0.01f, 10, 3),
+  COEF_MAPPING(amp_shape_b, 0.01f, 10, 3),
+  COEF_MAPPING(amp_time, 0.001f, 10, 4),
+  COEF_MAPPING(amp_shape_exp, 0.01f, 10, 3),
+  COEF_MAPPING(overtone_vol_shape_a, 0.01f, 10, 3),
+  COEF_MAPPING(overtone_vol_shape_b, 0.01f, 10, 3),
+  COEF_MAPPING(overtone_vol_time, 0.001f, 10, 4),
+  COEF_MAPPING(overtone_vol_shape_exp, 0.01f, 10, 3),
+  COEF_MAPPING(noise_shape_a, 0.01f, 10, 3),
+  COEF_MAPPING(noise_shape_b, 0.01f, 10, 3),
+  COEF_MAPPING(noise_time, 0.001f, 10, 4),
+  COEF_MAPPING(noise_shape_exp, 0.01f, 10, 3),
+  COEF_MAPPING(retrigger_period, 0.001f, 10, 3),
+  COEF_MAPPING(tune, 1, 2, 1 / 12.0f),
+};
+
+static inline float coef_map(const CoefMapping* const m, float setting) {
+  return m->scale * powf(m->base, setting * m->exp_scale);
+}
+
+void btedb_kick_params_compile(BtEdbKickParams* const p) {
+  for (unsigned i = 0; i < sizeof(coef_mappings) / sizeof(coef_mappings[0]); ++i) {
+    const CoefMapping* const m = &coef_mappings[i];
+    *(float*)((char*)p + m->coef) = coef_map(m, *(const float*)((const char*)p + m->setting));
+  }
+
+  btedb_kick_params_compile_derived(p);
+}
+
+int btedb_kick_params_compile_setting(size_t setting, const float* values, float* coefs, unsigned count) {
+  for (unsigned i = 0; i < sizeof(coef_mappings) / sizeof(coef_mappings[0]); ++i) {
+    const CoefMapping* const m = &coef_mappings[i];
+    if (m->setting != setting)
+      continue;
+
+    for (unsigned j = 0; j < count; ++j)
+      coefs[j] = coef_map(m, values[j]);
+
+    return (int)m->coef;
+  }
+
+  return -1;
+}
+
+void btedb_kick_params_compile_derived(BtEdbKickParams* const p) {
+  p->c_freq_start = p->c_tone_start * p->c_tune;
+
+  // Overtones past 'partials' are given no volume, so nothing else needs to check the count.
+  const unsigned partials = p->partials < BTEDB_KICK_OVERTONES ? p->partials : BTEDB_KICK_OVERTONES;
+
+  p->c_overtone_vols_sum = 0;
+  for (unsigned j = 0; j < BTEDB_KICK_OVERTONES; ++j) {
+    p->c_overtone_vols[j] = j < partials ? p->overtones[j] * p->overtone_vol : 0;
+    p->c_overtone_vols_sum += fabsf(p->c_overtone_vols[j]);
+  }
+}
+
+void btedb_kick_params_lerp(BtEdbKickParams* out, const BtEdbKickParams* a, const BtEdbKickParams* b, float alpha) {
+  const float* const fa = (const float*)a;
+  const float* const fb = (const float*)b;
+  float* const fout = (float*)out;
+
+  for (unsigned i = 0; i < offsetof(BtEdbKickParams, retrigger) / sizeof(float); ++i)
+    fout[i] = fa[i] + (fb[i] - fa[i]) * alpha;
+
+  out->retrigger = alpha < 0.5f ? a->retrigger : b->retrigger;
+  out->partials = a->partials > b->partials ? a->partials : b->partials;
+}
+
+void btedb_kick_sine_table_fill(float* table) {
+  for (unsigned i = 0; i < BTEDB_KICK_SINE_TABLE_SIZE; ++i)
+    table[i] = sin(TWO_PI * i / BTEDB_KICK_SINE_TABLE_SIZE);
+  table[BTEDB_KICK_SINE_TABLE_SIZE] = table[0];
+}
+
+// Pink noise octave updated at a given noise accumulator value. The highest octave takes every value the others
+// don't, including the accumulator wrapping to zero.
+static inline unsigned pink_octave(uint32_t accum) {
+  return __builtin_ctz(accum | (1u << (BTEDB_KICK_PINK_NOISE_OCTAVES - 2))) + 1;
+}
+
+// Each seed gives a different noise sequence; seeds are spread by a Fibonacci hash so that neighbouring ones don't give
+// sequences that are shifted copies of each other.
+static void noise_reset(BtEdbKickState* self, uint32_t seed) {
+  for (unsigned i = 0; i < BTEDB_KICK_PINK_NOISE_OCTAVES; ++i) {
+    self->lcg_state[i] = seed * 2654435769u + i;
+    self->lcg_noise[i] = 0;
+  }
+
+  self->noise = 0;
+  self->noise_last = 0;
+  self->pink_accum = 1;
+}
+
+// https://www.firstpr.com.au/dsp/pink-noise/#Voss-McCartney
+static inline void noise_update(BtEdbKickState* self, const BtEdbKickParams* const p) {
+  self->noise_last = self->noise;
+
+  // Add base white noise on each update. Otherwise, the highest frequency noise is only every other update.
+  self->noise -= self->lcg_noise[0];
+  self->lcg_noise[0] = lcg(&self->lcg_state[0]);
+  self->noise += self->lcg_noise[0];
+
+  // Subtracting the old noise value from an accumulated noise value avoids having to sum x stored noise
+  // values each update. As a result, some inertia is maintained if sweeping the octave value, but not a big
+  // deal.
+  //
+  // Select the noise state to update by counting trailing zeroes in the noise accumulator.
+  unsigned update_idx = pink_octave(self->pink_accum);
+  self->noise -= self->lcg_noise[update_idx];
+  if (update_idx <= p->noise_octaves) {
+    float octave_gain = fminf(1.0f, p->noise_octaves - (float)(update_idx+1));
+    self->lcg_noise[update_idx] = lcg(&self->lcg_state[update_idx]) * octave_gain;
+    self->noise += self->lcg_noise[update_idx];
+  } else {
+    self->lcg_noise[update_idx] = 0;
+  }
+
+  ++self->pink_accum;
+}
+
+// Bring freshly reset noise to where 'updates' calls to noise_update would leave it.
+//
+// The base octave is updated every time. Octave k of the rest is updated on accumulator values with k-1 trailing
+// zeroes, and the highest on all those with more. Octaves above 'noise_octaves' are silenced rather than updated.
+static void noise_skip(BtEdbKickState* self, const BtEdbKickParams* const p, uint64_t updates) {
+  if (updates == 0)
+    return;
+
+  // The value before the last update is needed too, for interpolating towards the current one.
+  self->noise = 0;
+  for (unsigned k = 0; k < BTEDB_KICK_PINK_NOISE_OCTAVES; ++k) {
+    const uint64_t before = updates - 1;
+    uint64_t octave_updates;
+    if (k == 0)
+      octave_updates = before;
+    else if (k < BTEDB_KICK_PINK_NOISE_OCTAVES - 1)
+      octave_updates = (before >> (k-1)) - (before >> k);
+    else
+      octave_updates = before >> (k-1);
+
+    if (octave_updates == 0 || (k > 0 && k > p->noise_octaves)) {
+      self->lcg_noise[k] = 0;
+      continue;
+    }
+
+    const float octave_gain = k == 0 ? 1.0f : fminf(1.0f, p->noise_octaves - (float)(k+1));
+    self->lcg_state[k] = lcg_skip(self->lcg_state[k], octave_updates);
+    self->lcg_noise[k] = lcg_float(self->lcg_state[k]) * octave_gain;
+    self->noise += self->lcg_noise[k];
+  }
+
+  self->pink_accum = (uint32_t)updates;
+  noise_update(self, p);
+}
+
+// Sweep frequency in double precision, for integrating over long spans.
+static double sweep_freq(const BtEdbKickParams* const p, double t, double start, double end) {
+  const double alpha = fmin(fmax(t / p->c_tone_time, 0), 1);
+  const double tau = pow(p->c_tone_shape_a + (p->c_tone_shape_b - p->c_tone_shape_a) * alpha, p->c_tone_shape_exp);
+  return start + (end - start) * -expm1(-t / tau);
+}
+
+// Phase covered by the sweep from its start until 'seconds' in, as the renderer accumulates it.
+//
+// While the envelope's shape is still changing, up to its time parameter, the sweep is integrated with Simpson's
+// rule. Past that, it's a plain exponential decay, which integrates exactly. The renderer sums the frequency at the
+// start of each sample, which falls short of the integral by half a sample's worth of the change in frequency.
+//
+// Where the renderer interpolates the sweep between points 'spacing' seconds apart, rather than evaluating it on
+// every sample, it runs ahead of the integral by spacing^2 / 12 of the change in the sweep's slope, on either side
+// of the corner at its time parameter.
+static double sweep_phase(
+  const BtEdbKickParams* const p, double seconds, double start, double end, double timedelta, double spacing
+) {
+  const unsigned intervals = 64;
+  const double shaped = fmin(seconds, p->c_tone_time);
+  const double h = shaped / intervals;
+
+  double sum = sweep_freq(p, 0, start, end) + sweep_freq(p, shaped, start, end);
+  for (unsigned i = 1; i < intervals; ++i)
+    sum += sweep_freq(p, i * h, start, end) * (i & 1 ? 4 : 2);
+
+  double integral = sum * h / 3;
+
+  if (seconds > shaped) {
+    const double tau = pow(p->c_tone_shape_b, p->c_tone_shape_exp);
+    integral += end * (seconds - shaped) + (start - end) * tau * exp(-shaped / tau) * -expm1(-(seconds - shaped) / tau);
+  }
+
+  integral -= timedelta / 2 * (sweep_freq(p, seconds, start, end) - sweep_freq(p, 0, start, end));
+
+  if (spacing > 0) {
+    const double d = 1e-7;
+    double slope_change =
+      (sweep_freq(p, shaped, start, end) - sweep_freq(p, shaped - d, start, end)) / d -
+      (sweep_freq(p, d, start, end) - sweep_freq(p, 0, start, end)) / d;
+
+    if (seconds > shaped) {
+      slope_change +=
+        (sweep_freq(p, seconds, start, end) - sweep_freq(p, seconds - d, start, end)) / d -
+        (sweep_freq(p, shaped + d, start, end) - sweep_freq(p, shaped, start, end)) / d;
+    }
+
+    integral += spacing * spacing / 12 * slope_change;
+  }
+
+  return TWO_PI * integral;
+}
+
+void btedb_kick_state_init(BtEdbKickState* self, const float* sine_table) {
+  memset(self, 0, sizeof(*self));
+
+  self->sine = sine_table;
+  noise_reset(self, 0);
+  btedb_kick_note_cut(self);
+}
+
+void btedb_kick_note_on(BtEdbKickState* self, const BtEdbKickParams* p, float freq, uint32_t seed) {
+  // Every note starts from the same phase, and noise that depends only on the seed, so that any point of it can be
+  // reproduced by btedb_kick_note_seek.
+  self->note_freq = freq;
+  self->frames = 0;
+  self->frame_offset = 0;
+  self->trigger_time = 0;
+  self->retrig_count = p->retrigger;
+  self->accum = 0;
+  self->overtone_accum = 0;
+  self->spacing_accum = 0;
+  noise_reset(self, seed);
+}
+
+void btedb_kick_note_cut(BtEdbKickState* self) {
+  // An hour after the last trigger, which every envelope has long finished with.
+  self->frames = 0;
+  self->frame_offset = 0;
+  self->trigger_time = -3600;
+  self->retrig_count = 0;
+}
+
+void btedb_kick_note_seek(
+  BtEdbKickState* self, const BtEdbKickParams* p, float freq, uint32_t seed, double seconds, unsigned rate) {
+  btedb_kick_note_on(self, p, freq, seed);
+
+  const double timedelta = 1.0 / rate;
+  const double period = p->c_retrigger_period;
+  const uint64_t frames = (uint64_t)floor(seconds * rate);
+  self->frames = frames;
+  self->frame_offset = fmax(seconds - (double)frames / rate, 0);
+
+  // The renderer retriggers on the first sample at or after each retrigger time.
+  unsigned retriggers = 0;
+  while (retriggers < p->retrigger && frame_at((retriggers + 1) * period, self->frame_offset, rate) < frames)
+    ++retriggers;
+
+  self->trigger_time = retriggers * period;
+  self->retrig_count = p->retrigger - retriggers;
+
+  // Each (re)trigger restarts the sweep. The first sample rendered after each one falls up to a sample after it, at
+  // 'offset', so the phase the samples cover is the difference between the sweep's phase at either end of them.
+  const double freq_start = p->c_freq_start;
+  const double freq_note = freq * p->c_tune;
+  const unsigned freq_decimation =
+    envelope_decimation(self, sweep_spacing(p, fabsf(p->c_freq_start - freq * p->c_tune)), rate);
+  const double spacing = freq_decimation > 1 ? freq_decimation * timedelta : 0;
+  double phase = 0;
+
+  for (unsigned k = 0; k <= retriggers; ++k) {
+    const uint64_t first = k == 0 ? 0 : frame_at(k * period, self->frame_offset, rate);
+    const uint64_t end = k < retriggers ? frame_at((k + 1) * period, self->frame_offset, rate) : frames;
+    const double offset = first * timedelta + self->frame_offset - k * period;
+    phase += sweep_phase(p, offset + (end - first) * timedelta, freq_start, freq_note, timedelta, spacing) -
+      sweep_phase(p, offset, freq_start, freq_note, timedelta, spacing);
+  }
+
+  self->accum = fmod(phase, TWO_PI);
+  self->overtone_accum = fmod(phase * (p->overtone_freq_factor + 1), TWO_PI);
+  self->spacing_accum = fmod(phase * p->overtone_freq_factor, TWO_PI);
+
+  // The renderer leaves the noise alone while it's silent. Otherwise, it's updated on the first sample of each
+  // group of 'decimation'.
+  if (p->noise_vol != 0.0) {
+    const unsigned decimation = noise_decimation(rate);
+    noise_skip(self, p, (frames + decimation - 1) / decimation);
+  }
+}
+
+int btedb_kick_is_idle(const BtEdbKickState* self, const BtEdbKickParams* p, unsigned rate) {
+  return is_idle(p, (float)(note_time(self, rate) - self->trigger_time), self->retrig_count);
+}
+
+int btedb_kick_render(BtEdbKickState* self, const BtEdbKickParams* p, float* out, unsigned frames, unsigned rate) {
+  const float freq_note = self->note_freq * p->c_tune;
+  const float freq_start = p->c_freq_start;
+
+  const float timedelta = 1.0f/rate;
+
+  const float* const overtone_vols = p->c_overtone_vols;
+
+  const float seconds = (float)(note_time(self, rate) - self->trigger_time);
+
+  if (is_idle(p, seconds, self->retrig_count)) {
+    self->frames += frames;
+    self->levels = (BtEdbKickLevels){0, 0, 0};
+    return 0;
+  }
+
+  // Work out which overtones can be heard at all during this block.
+  //
+  // The sweep and the envelopes are evaluated at both ends of the block and taken as bounding it. If a retrigger
+  // falls inside the block, the envelopes restart, so the block is bounded by their start values instead.
+  const float nyquist = rate * 0.5f;
+  const float nyquist_fade_start = nyquist * (1 - NYQUIST_FADE);
+  const float block_seconds = frames * timedelta;
+  const int block_retriggers =
+    self->retrig_count > 0 && self->trigger_time + p->c_retrigger_period < note_time(self, rate) + block_seconds;
+  const float t0 = block_retriggers ? 0 : seconds;
+  const float t1 = seconds + block_seconds;
+  const float freq_t0 = btedb_kick_freq(p, t0, freq_start, freq_note);
+  const float freq_t1 = btedb_kick_freq(p, t1, freq_start, freq_note);
+  const float freq_min = fminf(freq_t0, freq_t1);
+  const float freq_max = fmaxf(freq_t0, freq_t1);
+  const float level_max =
+    fmaxf(btedb_kick_overtone_env(p, t0) * btedb_kick_amp(p, t0),
+          btedb_kick_overtone_env(p, t1) * btedb_kick_amp(p, t1)) * p->volume;
+
+  // Overtones are stepped through in order, so they're rendered up to the last one that can be heard, and any
+  // before that which can't are given no volume. Overtone frequencies rise with their index, so the first one
+  // that's above Nyquist for the whole block ends the list. 'crosses_nyquist' is set if any rendered overtone reaches
+  // the band faded out below Nyquist during the block, in which case each sample is faded by how far into it it is.
+  float vols[BTEDB_KICK_OVERTONES];
+  unsigned count = 0;
+  int crosses_nyquist = 0;
+
+  if (p->overtone_vol != 0.0) {
+    for (unsigned j = 0; j < BTEDB_KICK_OVERTONES; ++j) {
+      const float mul = (j+1)*p->overtone_freq_factor + 1;
+
+      if (freq_min * mul >= nyquist)
+        break;
+
+      // Note: overtone_vols already pre-multiplied by overtone_vol.
+      if (overtone_vols[j] == 0.0 || fabsf(overtone_vols[j]) * level_max < PARTIAL_CULL_LEVEL) {
+        vols[j] = 0;
+        continue;
+      }
+
+      vols[j] = overtone_vols[j];
+      crosses_nyquist |= freq_max * mul > nyquist_fade_start;
+      count = j+1;
+    }
+  }
+
+  // Each of the sweep and envelopes is evaluated only as often as its shape needs, and interpolated between.
+  const int noisy = p->noise_vol != 0.0;
+  const unsigned freq_decimation =
+    envelope_decimation(self, sweep_spacing(p, fabsf(freq_start - freq_note)), rate);
+  const unsigned amp_decimation =
+    envelope_decimation(self, shape_spacing(p->c_amp_shape_a, p->c_amp_shape_b, p->c_amp_shape_exp), rate);
+  const unsigned overtone_decimation = envelope_decimation(
+    self, shape_spacing(p->c_overtone_vol_shape_a, p->c_overtone_vol_shape_b, p->c_overtone_vol_shape_exp), rate);
+  const unsigned noise_env_decimation =
+    envelope_decimation(self, shape_spacing(p->c_noise_shape_a, p->c_noise_shape_b, p->c_noise_shape_exp), rate);
+  const unsigned pink_decimation = noise_decimation(rate);
+
+  // Envelope shapes have a corner where they stop changing, at their time parameter. Passes end at those of the
+  // interpolated envelopes, so that no interpolation spans one.
+  float corners[4];
+  unsigned corner_count = 0;
+  if (freq_decimation > 1)
+    corners[corner_count++] = p->c_tone_time;
+  if (amp_decimation > 1)
+    corners[corner_count++] = p->c_amp_time;
+  if (count != 0 && overtone_decimation > 1)
+    corners[corner_count++] = p->c_overtone_vol_time;
+  if (noisy && noise_env_decimation > 1)
+    corners[corner_count++] = p->c_noise_time;
+
+  float envelope = 0;
+  float peak = 0;
+  float sum_sq = 0;
+
+  for (unsigned pass = 0; pass < frames;) {
+    unsigned n = frames - pass < PASS_FRAMES ? frames - pass : PASS_FRAMES;
+
+    // Retriggers happen on the first sample at or after their time. Passes end before them, so that time within a
+    // pass is a plain ramp.
+    if (self->retrig_count > 0) {
+      const double retrigger_time = self->trigger_time + p->c_retrigger_period;
+      const uint64_t retrigger_frame = frame_at(retrigger_time, self->frame_offset, rate);
+
+      if (retrigger_frame <= self->frames) {
+        self->trigger_time = retrigger_time;
+        --self->retrig_count;
+        continue;
+      }
+
+      if (retrigger_frame - self->frames < n)
+        n = retrigger_frame - self->frames;
+    }
+
+    for (unsigned c = 0; c < corner_count; ++c) {
+      const uint64_t corner_frame = frame_at(self->trigger_time + corners[c], self->frame_offset, rate);
+      if (corner_frame > self->frames && corner_frame - self->frames < n)
+        n = corner_frame - self->frames;
+    }
+
+    float gain[PASS_FRAMES];
+    float freqs[PASS_FRAMES];
+    float amp_env[PASS_FRAMES];
+    float overtone_env[PASS_FRAMES];
+    float noise_env[PASS_FRAMES];
+    float phase[PASS_FRAMES];
+    float overtone_phase[PASS_FRAMES];
+    float spacing_phase[PASS_FRAMES];
+    float sample[PASS_FRAMES];
+
+    // Only the start of the pass is worked out from the sample clock, in double precision. Relative to that, times
+    // within the pass are small enough to be exact in single precision.
+    const float pass_seconds = (float)(note_time(self, rate) - self->trigger_time);
+
+    for (unsigned i = 0; i < n; ++i)
+      gain[i] = lerp(0, p->volume, (pass_seconds + i * timedelta) / p->anticlick);
+
+    envelope_pass(
+      freqs, n, freq_decimation, pass_seconds, timedelta, freq_start, freq_note,
+      p->c_tone_shape_a, p->c_tone_shape_b, p->c_tone_time, p->c_tone_shape_exp);
+    envelope_pass(
+      amp_env, n, amp_decimation, pass_seconds, timedelta, 1, 0,
+      p->c_amp_shape_a, p->c_amp_shape_b, p->c_amp_time, p->c_amp_shape_exp);
+    if (count != 0) {
+      envelope_pass(
+        overtone_env, n, overtone_decimation, pass_seconds, timedelta, 1, 0,
+        p->c_overtone_vol_shape_a, p->c_overtone_vol_shape_b, p->c_overtone_vol_time, p->c_overtone_vol_shape_exp);
+    }
+    if (noisy) {
+      envelope_pass(
+        noise_env, n, noise_env_decimation, pass_seconds, timedelta, 1, 0,
+        p->c_noise_shape_a, p->c_noise_shape_b, p->c_noise_time, p->c_noise_shape_exp);
+    }
+
+    for (unsigned i = 0; i < n; ++i) {
+      phase[i] = self->accum;
+      overtone_phase[i] = self->overtone_accum;
+      spacing_phase[i] = self->spacing_accum;
+
+      const float step = (float)TWO_PI * timedelta * freqs[i];
+      self->accum += step;
+      self->overtone_accum += step * (p->overtone_freq_factor + 1);
+      self->spacing_accum += step * p->overtone_freq_factor;
+    }
+
+    if (p->fundamental_vol != 0.0) {
+      for (unsigned i = 0; i < n; ++i)
+        sample[i] = btedb_kick_sine(self->sine, phase[i]) * p->fundamental_vol;
+    } else {
+      for (unsigned i = 0; i < n; ++i)
+        sample[i] = 0;
+    }
+
+    // Each overtone's phase is a fixed step on from the one before it, so rather than looking each one up, a
+    // phasor for the first overtone is rotated by a phasor for the step. Per overtone, that's a complex multiply
+    // for each sample of the pass.
+    if (count != 0) {
+      float re[PASS_FRAMES];
+      float im[PASS_FRAMES];
+      float step_re[PASS_FRAMES];
+      float step_im[PASS_FRAMES];
+      float otones[PASS_FRAMES];
+
+      for (unsigned i = 0; i < n; ++i) {
+        re[i] = btedb_kick_sine(self->sine, overtone_phase[i] + (float)(BTEDB_KICK_PI / 2));
+        im[i] = btedb_kick_sine(self->sine, overtone_phase[i]);
+        step_re[i] = btedb_kick_sine(self->sine, spacing_phase[i] + (float)(BTEDB_KICK_PI / 2));
+        step_im[i] = btedb_kick_sine(self->sine, spacing_phase[i]);
+        otones[i] = 0;
+      }
+
+      for (unsigned j = 0; j < count; ++j) {
+        const float vol = vols[j];
+
+        if (vol != 0 && crosses_nyquist) {
+          const float mul = (j+1)*p->overtone_freq_factor + 1;
+          const float fade = 1 / (NYQUIST_FADE * nyquist);
+          for (unsigned i = 0; i < n; ++i)
+            otones[i] += im[i] * vol * fminf(fmaxf((nyquist - freqs[i] * mul) * fade, 0), 1);
+        } else if (vol != 0) {
+          for (unsigned i = 0; i < n; ++i)
+            otones[i] += im[i] * vol;
+        }
+
+        for (unsigned i = 0; i < n; ++i) {
+          const float next_re = re[i] * step_re[i] - im[i] * step_im[i];
+          im[i] = re[i] * step_im[i] + im[i] * step_re[i];
+          re[i] = next_re;
+        }
+      }
+
+      for (unsigned i = 0; i < n; ++i)
+        sample[i] += otones[i] * overtone_env[i];
+    }
+
+    for (unsigned i = 0; i < n; ++i)
+      sample[i] *= amp_env[i];
+
+    // At high rates, the noise is updated on the first sample of each group of 'pink_decimation', and the samples of
+    // the group ramp from the value before that update to the value after it, which the last of them reaches.
+    if (noisy) {
+      float noise[PASS_FRAMES];
+
+      if (pink_decimation == 1) {
+        for (unsigned i = 0; i < n; ++i) {
+          noise_update(self, p);
+          noise[i] = self->noise;
+        }
+      } else {
+        const float noise_step = 1.0f / pink_decimation;
+        for (unsigned i = 0; i < n; ++i) {
+          const unsigned step = (self->frames + i) & (pink_decimation - 1);
+          if (step == 0)
+            noise_update(self, p);
+          noise[i] = self->noise_last + (self->noise - self->noise_last) * ((step + 1) * noise_step);
+        }
+      }
+
+      for (unsigned i = 0; i < n; ++i)
+        sample[i] += (noise[i] / p->noise_octaves) * noise_env[i] * p->noise_vol;
+    }
+
+    for (unsigned i = 0; i < n; ++i) {
+      const float s = sample[i] * gain[i];
+      out[pass + i] += s;
+
+      envelope = fmaxf(envelope, amp_env[i] * gain[i]);
+      peak = fmaxf(peak, fabsf(s));
+      sum_sq += s * s;
+    }
+
+    self->accum = wrap_phase(self->accum);
+    self->overtone_accum = wrap_phase(self->overtone_accum);
+    self->spacing_accum = wrap_phase(self->spacing_accum);
+
+    self->frames += n;
+    pass += n;
+  }
+
+  self->levels.envelope = envelope;
+  self->levels.peak = peak;
+  self->levels.rms = frames ? sqrtf(sum_sq / frames) : 0;
+
+  return 1;
+}
@@ -0,0 +1,222 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+  The kick synthesis engine, free of GLib and GStreamer so that it can be driven from anything.
+
+  A voice is a BtEdbKickState, rendered with a BtEdbKickParams:
+
+    BtEdbKickParams params = { ...settings... };
+    btedb_kick_params_compile(&params);
+
+    btedb_kick_state_init(&state, sine_table);
+    btedb_kick_note_on(&state, &params, 440, seed);
+    btedb_kick_render(&state, &params, out, frames, rate);
+
+  The settings have the same meaning and ranges as the GStreamer element's properties of the same names.
+*/
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// The most overtones a voice can have; 'partials' selects how many of them are rendered.
+#define BTEDB_KICK_OVERTONES 64
+#define BTEDB_KICK_PINK_NOISE_OCTAVES 17
+
+// math.h only defines M_PI outside strict ISO C.
+#define BTEDB_KICK_PI 3.14159265358979323846
+
+#define BTEDB_KICK_SINE_TABLE_BITS 12
+#define BTEDB_KICK_SINE_TABLE_SIZE (1 << BTEDB_KICK_SINE_TABLE_BITS)
+
+// Bump whenever BtEdbKickParams or the formulas btedb_kick_params_compile uses change, so that parameter sets
+// stored by an older build are refused.
+#define BTEDB_KICK_PARAMS_VERSION 1
+
+// Settings, and the coefficients compiled from them by btedb_kick_params_compile.
+typedef struct {
+  float tone_start;
+  float tone_time;
+  float tone_shape_a;
+  float tone_shape_b;
+  float tone_shape_exp;
+  float amp_time;
+  float amp_shape_a;
+  float amp_shape_b;
+  float amp_shape_exp;
+  float tune;
+  float noise_octaves;
+  float noise_time;
+  float noise_shape_a;
+  float noise_shape_b;
+  float noise_shape_exp;
+  float noise_vol;
+  float fundamental_vol;
+  float overtone_vol;
+  float overtone_vol_time;
+  float overtone_vol_shape_a;
+  float overtone_vol_shape_b;
+  float overtone_vol_shape_exp;
+  float overtone_freq_factor;
+  float overtones[BTEDB_KICK_OVERTONES];
+  float volume;
+  float retrigger_period;
+  float anticlick;
+
+  float c_tone_start;
+  float c_tone_time;
+  float c_tone_shape_a;
+  float c_tone_shape_b;
+  float c_tone_shape_exp;
+  float c_amp_time;
+  float c_amp_shape_a;
+  float c_amp_shape_b;
+  float c_amp_shape_exp;
+  float c_noise_time;
+  float c_noise_shape_a;
+  float c_noise_shape_b;
+  float c_noise_shape_exp;
+  float c_overtone_vol_time;
+  float c_overtone_vol_shape_a;
+  float c_overtone_vol_shape_b;
+  float c_overtone_vol_shape_exp;
+  float c_retrigger_period;
+  float c_tune;
+  float c_freq_start;
+  float c_overtone_vols[BTEDB_KICK_OVERTONES];  // Pre-multiplied by overtone_vol.
+  float c_overtone_vols_sum;                    // Sum of their magnitudes.
+
+  // Kept last: everything before these is a float, which btedb_kick_params_lerp relies on.
+  unsigned retrigger;
+  unsigned partials;
+} BtEdbKickParams;
+
+// Levels measured over a rendered block.
+typedef struct {
+  float envelope; // Peak of the amplitude envelope, including volume.
+  float peak;
+  float rms;
+} BtEdbKickLevels;
+
+typedef struct {
+  const float* sine;
+  float note_freq;
+
+  // Time since note-on, as samples rendered plus the time of the first of them, which is under a sample for notes
+  // that didn't start on one. Envelope time is that less the time of the last (re)trigger.
+  uint64_t frames;
+  double frame_offset;
+  double trigger_time;
+  unsigned retrig_count;
+
+  uint32_t lcg_state[BTEDB_KICK_PINK_NOISE_OCTAVES];
+  float lcg_noise[BTEDB_KICK_PINK_NOISE_OCTAVES];
+  float noise;
+  float noise_last; // Before the last update, for interpolating at rates where noise is updated less than per sample.
+  uint32_t pink_accum;
+  // Phases of the fundamental and the first overtone, and of the spacing between overtones. Overtone n's phase is
+  // always overtone_accum + n * spacing_accum, which is what lets them all be rendered from two lookups.
+  float accum;
+  float overtone_accum;
+  float spacing_accum;
+
+  // Measured by the last call to btedb_kick_render.
+  BtEdbKickLevels levels;
+
+  // Set to evaluate the sweep and envelopes at every sample rather than interpolating them, as a reference for
+  // testing. Cleared by btedb_kick_state_init.
+  int full_rate;
+} BtEdbKickState;
+
+void btedb_kick_params_compile(BtEdbKickParams* p);
+
+// For following a setting as it changes, without recompiling the whole set for each value.
+//
+// Compile the coefficient for each of 'count' values of the setting at offset 'setting' in BtEdbKickParams.
+// Returns the offset of that coefficient, or -1 if the setting is used as it is and 'coefs' is left untouched.
+// Afterwards, btedb_kick_params_compile_derived brings the coefficients that combine several settings up to date.
+int btedb_kick_params_compile_setting(size_t setting, const float* values, float* coefs, unsigned count);
+void btedb_kick_params_compile_derived(BtEdbKickParams* p);
+
+// Interpolate between two parameter sets. 'retrigger' is taken from whichever set is nearest, and 'partials' is the
+// larger of the two so that overtones being faded in or out aren't cut off.
+void btedb_kick_params_lerp(BtEdbKickParams* out, const BtEdbKickParams* a, const BtEdbKickParams* b, float alpha);
+
+// Fill a table of BTEDB_KICK_SINE_TABLE_SIZE + 1 entries: one cycle of a sine wave, with the first entry repeated
+// at the end for interpolation.
+void btedb_kick_sine_table_fill(float* table);
+
+// The sine table is only read, so may be shared between any number of states.
+void btedb_kick_state_init(BtEdbKickState* self, const float* sine_table);
+
+// Start a note sounding at the given frequency, before tuning. The noise depends only on 'seed', so notes with
+// different seeds differ; something that identifies the note, like its position in the stream, makes a good one.
+void btedb_kick_note_on(BtEdbKickState* self, const BtEdbKickParams* p, float freq, uint32_t seed);
+
+// Silence the voice until the next note.
+void btedb_kick_note_cut(BtEdbKickState* self);
+
+// Start a note part way through: as if it had been started with 'seed' 'seconds' ago and rendered at 'rate' ever
+// since, with the same settings. Costs the same however far in that is, so it can be used to pick notes up again
+// after seeking.
+void btedb_kick_note_seek(
+  BtEdbKickState* self, const BtEdbKickParams* p, float freq, uint32_t seed, double seconds, unsigned rate);
+
+// True if the voice can't be heard again until the next note, in which case btedb_kick_render won't touch 'out'.
+int btedb_kick_is_idle(const BtEdbKickState* self, const BtEdbKickParams* p, unsigned rate);
+
+// Mix a block into 'out'. Returns 0 if the voice was silent for the whole block, in which case 'out' is left
+// untouched.
+int btedb_kick_render(BtEdbKickState* self, const BtEdbKickParams* p, float* out, unsigned frames, unsigned rate);
+
+// Linearly interpolated lookup into a sine table. Phase is in radians, and must not be negative.
+static inline float btedb_kick_sine(const float* const table, const float phase) {
+  const float x = phase * (float)(BTEDB_KICK_SINE_TABLE_SIZE / (2 * BTEDB_KICK_PI));
+  const unsigned i = (unsigned)x;
+  const float frac = x - (float)i;
+  const float* const entry = &table[i & (BTEDB_KICK_SINE_TABLE_SIZE - 1)];
+  return entry[0] + (entry[1] - entry[0]) * frac;
+}
+
+static inline float btedb_kick_decay(float t, float start, float end, float a, float b, float decay_time, float power) {
+  const float alpha = fmaxf(fminf(t / decay_time, 1), 0);
+  return start + (end - start) * (1 - expf(-t / powf(a + (b-a) * alpha, power)));
+}
+
+static inline float btedb_kick_amp(const BtEdbKickParams* const p, const float seconds) {
+  return btedb_kick_decay(seconds, 1, 0, p->c_amp_shape_a, p->c_amp_shape_b, p->c_amp_time, p->c_amp_shape_exp);
+}
+
+static inline float btedb_kick_freq(const BtEdbKickParams* const p, float seconds, float start, float end) {
+  return btedb_kick_decay(
+    seconds, start, end, p->c_tone_shape_a, p->c_tone_shape_b, p->c_tone_time, p->c_tone_shape_exp);
+}
+
+static inline float btedb_kick_overtone_env(const BtEdbKickParams* const p, float seconds) {
+  return btedb_kick_decay(
+    seconds, 1, 0, p->c_overtone_vol_shape_a, p->c_overtone_vol_shape_b, p->c_overtone_vol_time,
+    p->c_overtone_vol_shape_exp);
+}
+
+static inline float btedb_kick_noise_env(const BtEdbKickParams* const p, float seconds) {
+  return btedb_kick_decay(
+    seconds, 1, 0, p->c_noise_shape_a, p->c_noise_shape_b, p->c_noise_time, p->c_noise_shape_exp);
+}
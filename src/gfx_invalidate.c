@@ -0,0 +1,65 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "src/gfx_invalidate.h"
+
+typedef struct {
+  GSource source;
+  gint pending;
+  GWeakRef object;
+} GfxInvalidateSource;
+
+// Only touches the flag, so polling costs no locking.
+static gboolean prepare(GSource* source, gint* timeout) {
+  *timeout = -1;
+  return g_atomic_int_get(&((GfxInvalidateSource*)source)->pending);
+}
+
+static gboolean check(GSource* source) {
+  return g_atomic_int_get(&((GfxInvalidateSource*)source)->pending);
+}
+
+static gboolean dispatch(GSource* source, GSourceFunc callback, gpointer user_data) {
+  GfxInvalidateSource* const self = (GfxInvalidateSource*)source;
+  g_atomic_int_set(&self->pending, FALSE);
+
+  GObject* const object = g_weak_ref_get(&self->object);
+  if (object) {
+    g_signal_emit_by_name(object, "gstbt-ui-custom-gfx-invalidated", 0);
+    g_object_unref(object);
+  }
+  return G_SOURCE_CONTINUE;
+}
+
+static void finalize(GSource* source) {
+  g_weak_ref_clear(&((GfxInvalidateSource*)source)->object);
+}
+
+static GSourceFuncs funcs = { prepare, check, dispatch, finalize, NULL, NULL };
+
+GSource* btedb_gfx_invalidate_new(GObject* object) {
+  GSource* const source = g_source_new(&funcs, sizeof(GfxInvalidateSource));
+  g_weak_ref_init(&((GfxInvalidateSource*)source)->object, object);
+  g_source_set_priority(source, G_PRIORITY_DEFAULT_IDLE);
+  return source;
+}
+
+void btedb_gfx_invalidate_raise(GSource* source) {
+  if (g_atomic_int_compare_and_exchange(&((GfxInvalidateSource*)source)->pending, FALSE, TRUE))
+    g_main_context_wakeup(g_main_context_default());
+}
@@ -0,0 +1,36 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-object.h>
+
+/*
+  A main context source that emits "gstbt-ui-custom-gfx-invalidated" on an object.
+
+  Listeners to that signal are UI code, so it's emitted from the default main context rather than whichever thread
+  changed a property, which may well be the streaming thread syncing controlled values. Raising the source doesn't
+  block or allocate, so is safe from the streaming thread. Raises before the next dispatch are coalesced.
+
+  Attach the source to the default main context. It holds no reference to its object, so doesn't keep it alive. One
+  is meant to serve everything that invalidates an object's graphics, so the main loop polls a single flag however
+  many voices feed it.
+*/
+GSource* btedb_gfx_invalidate_new(GObject* object);
+
+void btedb_gfx_invalidate_raise(GSource* source);
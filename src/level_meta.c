@@ -0,0 +1,72 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "src/level_meta.h"
+#include <string.h>
+
+static gboolean level_meta_init(GstMeta* meta, gpointer params, GstBuffer* buffer) {
+  BtEdbLevelMeta* const self = (BtEdbLevelMeta*)meta;
+  self->voices = 0;
+  memset(self->voice, 0, sizeof(self->voice));
+  memset(&self->mix, 0, sizeof(self->mix));
+  return TRUE;
+}
+
+static gboolean level_meta_transform(
+  GstBuffer* dest, GstMeta* meta, GstBuffer* buffer, GQuark type, gpointer data) {
+  // The levels describe the whole buffer, so they only survive a complete copy.
+  if (!GST_META_TRANSFORM_IS_COPY(type) || ((GstMetaTransformCopy*)data)->region)
+    return TRUE;
+
+  BtEdbLevelMeta* const src = (BtEdbLevelMeta*)meta;
+  BtEdbLevelMeta* const result = btedb_buffer_add_level_meta(dest);
+  if (!result)
+    return FALSE;
+  
+  result->voices = src->voices;
+  memcpy(result->voice, src->voice, sizeof(result->voice));
+  result->mix = src->mix;
+  return TRUE;
+}
+
+GType btedb_level_meta_api_get_type(void) {
+  static gsize type = 0;
+  static const gchar* tags[] = { GST_META_TAG_AUDIO_STR, NULL };
+
+  if (g_once_init_enter(&type)) {
+    GType _type = gst_meta_api_type_register(BTEDB_LEVEL_META_API_NAME, tags);
+    g_once_init_leave(&type, _type);
+  }
+  return type;
+}
+
+const GstMetaInfo* btedb_level_meta_get_info(void) {
+  static const GstMetaInfo* info = NULL;
+
+  if (g_once_init_enter((gsize*)&info)) {
+    const GstMetaInfo* _info = gst_meta_register(
+      btedb_level_meta_api_get_type(), "BtEdbLevelMeta", sizeof(BtEdbLevelMeta), level_meta_init, NULL,
+      level_meta_transform);
+    g_once_init_leave((gsize*)&info, (gsize)_info);
+  }
+  return info;
+}
+
+BtEdbLevelMeta* btedb_buffer_add_level_meta(GstBuffer* buffer) {
+  return (BtEdbLevelMeta*)gst_buffer_add_meta(buffer, btedb_level_meta_get_info(), NULL);
+}
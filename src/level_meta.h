@@ -0,0 +1,27 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "src/level_meta_api.h"
+
+// The plugin's side: registering the meta and attaching it to buffers.
+GType btedb_level_meta_api_get_type(void);
+const GstMetaInfo* btedb_level_meta_get_info(void);
+
+BtEdbLevelMeta* btedb_buffer_add_level_meta(GstBuffer* buffer);
@@ -0,0 +1,57 @@
+/*
+  Kick machine for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+/*
+  Levels the kick machine attaches to each buffer it renders, for elements downstream of it.
+
+  This header is installed and depends only on GStreamer. The plugin registers the meta from its plugin_init, so
+  nothing needs linking against it:
+
+    const BtEdbLevelMeta* meta = btedb_buffer_get_level_meta(buffer);
+    if (meta)
+      duck(meta->mix.envelope);
+*/
+
+#include <gst/gst.h>
+
+#define BTEDB_LEVEL_META_API_NAME "BtEdbLevelMetaAPI"
+#define BTEDB_LEVEL_META_MAX_VOICES 16
+
+typedef struct {
+  gfloat envelope; // Peak of the amplitude envelope, including volume.
+  gfloat peak;
+  gfloat rms;
+} BtEdbLevelMetaLevels;
+
+// Levels of the voices and the mix over the buffer it's attached to. Only the first 'voices' entries of 'voice' are
+// set.
+typedef struct {
+  GstMeta meta;
+
+  guint voices;
+  BtEdbLevelMetaLevels voice[BTEDB_LEVEL_META_MAX_VOICES];
+  BtEdbLevelMetaLevels mix;
+} BtEdbLevelMeta;
+
+// Returns NULL if the buffer has no levels attached, including when the plugin hasn't been loaded.
+static inline const BtEdbLevelMeta* btedb_buffer_get_level_meta(GstBuffer* buffer) {
+  const GType api = g_type_from_name(BTEDB_LEVEL_META_API_NAME);
+  return api ? (const BtEdbLevelMeta*)gst_buffer_get_meta(buffer, api) : NULL;
+}
@@ -0,0 +1,104 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "src/level_source.h"
+
+#define HISTORY 16
+
+typedef struct {
+  GstClockTime time;
+  gdouble value;
+} Entry;
+
+struct _BtEdbLevelSource
+{
+  GstControlSource parent;
+
+  // Written by the streaming thread only, and read from any thread under 'sequence', a seqlock: it's odd while a push
+  // is under way, and readers retry if it changed while they looked.
+  gint sequence;
+  Entry history[HISTORY];
+  // Index of the newest entry and the number of entries in use.
+  gint head;
+  gint filled;
+};
+
+G_DEFINE_TYPE(BtEdbLevelSource, btedb_level_source, GST_TYPE_CONTROL_SOURCE)
+
+void btedb_level_source_push(BtEdbLevelSource* self, GstClockTime time, gfloat value) {
+  const gint head = (self->head + 1) % HISTORY;
+
+  // g_atomic_int_inc is a full barrier, so the entry isn't written until readers can see a push is under way.
+  g_atomic_int_inc(&self->sequence);
+  self->history[head].time = time;
+  self->history[head].value = CLAMP(value, 0, 1);
+  self->head = head;
+  self->filled = MIN(self->filled + 1, HISTORY);
+  g_atomic_int_inc(&self->sequence);
+}
+
+// Pushes are a handful of stores made once per block, so a reader that catches one is retried straight away.
+static gboolean lookup(BtEdbLevelSource* self, GstClockTime timestamp, gdouble* value) {
+  for (;;) {
+    const gint sequence = g_atomic_int_get(&self->sequence);
+    if (sequence & 1)
+      continue;
+
+    const gint head = self->head;
+    const gint count = self->filled;
+    gdouble found = 0;
+    for (gint i = 0; i < count; ++i) {
+      const Entry* const entry = &self->history[(head - i + HISTORY) % HISTORY];
+      if (entry->time <= timestamp || i == count - 1) {
+        found = entry->value;
+        break;
+      }
+    }
+
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (g_atomic_int_get(&self->sequence) != sequence)
+      continue;
+
+    if (count == 0)
+      return FALSE;
+    *value = found;
+    return TRUE;
+  }
+}
+
+static gboolean get_value(GstControlSource* source, GstClockTime timestamp, gdouble* value) {
+  return lookup((BtEdbLevelSource*)source, timestamp, value);
+}
+
+static gboolean get_value_array(
+  GstControlSource* source, GstClockTime timestamp, GstClockTime interval, guint n_values, gdouble* values) {
+  for (guint i = 0; i < n_values; ++i) {
+    if (!lookup((BtEdbLevelSource*)source, timestamp + interval * i, &values[i]))
+      return FALSE;
+  }
+  return TRUE;
+}
+
+static void btedb_level_source_class_init(BtEdbLevelSourceClass* const klass) {
+}
+
+static void btedb_level_source_init(BtEdbLevelSource* const self) {
+  GstControlSource* const source = (GstControlSource*)self;
+  source->get_value = get_value;
+  source->get_value_array = get_value_array;
+}
@@ -0,0 +1,33 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <glib-object.h>
+#include <gst/gst.h>
+
+/*
+  A control source that follows a level measured by the machine, so that other machines' properties can be bound
+  to it, i.e. for ducking.
+
+  The streaming thread pushes a value per rendered block. Lookups return the newest value at or before the requested
+  time, out of a short history, clamped to the 0-1 range expected of control sources.
+*/
+G_DECLARE_FINAL_TYPE(BtEdbLevelSource, btedb_level_source, BTEDB, LEVEL_SOURCE, GstControlSource);
+
+void btedb_level_source_push(BtEdbLevelSource* self, GstClockTime time, gfloat value);
@@ -18,7 +18,11 @@
 
 #include "config.h"
 #include "src/debug.h"
+#include "src/gfx_invalidate.h"
+#include "src/level_meta.h"
+#include "src/level_source.h"
 #include "src/properties_simple.h"
+#include "src/slot_bank.h"
 #include "src/voice.h"
 
 #include "libbuzztrax-gst/audiosynth.h"
@@ -33,6 +37,29 @@ GST_DEBUG_CATEGORY(GST_CAT_DEFAULT);
 GType btedb_kick_get_type(void);
 
 #define MAX_VOICES 16
+#define MAX_SLOTS 64
+
+// Set on 'slots_middle' when it holds a bank the streaming thread hasn't picked up yet.
+#define SLOTS_FRESH ((guintptr)1)
+
+enum {
+  PROP_CHILDREN = 1,
+  PROP_SLOT,
+  PROP_MORPH_SLOT,
+  PROP_MORPH,
+  PROP_SLOT_CAPTURE,
+  PROP_SLOT_PRESETS,
+  PROP_SLOT_BANK,
+  PROP_SLOT_BANK_SAVE,
+  PROP_ENVELOPE,
+  PROP_PEAK,
+  PROP_RMS,
+  PROP_ENVELOPE_SOURCE,
+  PROP_PEAK_SOURCE,
+  PROP_RMS_SOURCE
+};
+
+G_STATIC_ASSERT(BTEDB_LEVEL_META_MAX_VOICES == MAX_VOICES);
 
 typedef struct {
   GstBtAudioSynth parent;
@@ -40,6 +67,28 @@ typedef struct {
   guint children;
   BtEdbKickV* voices[MAX_VOICES];
   BtEdbPropertiesSimple* props;
+
+  guint slot;
+  guint morph_slot;
+  gfloat morph;
+  gchar* slot_bank_path;
+
+  // Slot banks are handed to the streaming thread in the same way as voice parameters. 'slots_lock' serializes
+  // writers, which own 'slots_latest'; the streaming thread owns 'slots_front'.
+  GMutex slots_lock;
+  BtEdbSlotBank* slots_latest;
+  guintptr slots_middle;
+  BtEdbSlotBank* slots_front;
+  BtEdbKickParams slots_morphed[MAX_VOICES];
+
+  // Levels of the mix over the last block. Written by the streaming thread; a stale read is harmless.
+  BtEdbKickLevels levels;
+  BtEdbLevelSource* envelope_source;
+  BtEdbLevelSource* peak_source;
+  BtEdbLevelSource* rms_source;
+
+  // Emits the machine's invalidated signal when the first voice's properties change; that voice draws its graphics.
+  GSource* gfx_invalidate;
 } BtEdbKick;
 
 typedef struct {
@@ -51,7 +100,7 @@ static GObject* child_proxy_get_child_by_index (GstChildProxy *child_proxy, guin
 
   g_return_val_if_fail(index < MAX_VOICES, NULL);
 
-  return gst_object_ref(self->voices[index]);
+  return self->voices[index] ? gst_object_ref(self->voices[index]) : NULL;
 }
 
 static guint child_proxy_get_children_count (GstChildProxy *child_proxy) {
@@ -83,6 +132,10 @@ static gboolean plugin_init(GstPlugin* plugin) {
     GST_DEBUG_FG_WHITE | GST_DEBUG_BG_BLACK,
     GST_PLUGIN_DESC);
 
+  // Registered up front rather than with the first buffer, so that downstream elements can look the meta up by name
+  // as soon as the plugin is loaded.
+  btedb_level_meta_get_info();
+
   return gst_element_register(
     plugin,
     G_STRINGIFY(GST_PLUGIN_NAME),
@@ -111,37 +164,269 @@ static const GstBtUiCustomGfxResponse* on_gfx_request(GstBtUiCustomGfx* self) {
   return gstbt_ui_custom_gfx_request(GSTBT_UI_CUSTOM_GFX(((BtEdbKick*)self)->voices[0]));
 }
 
-static void on_voice_gfx_invalidated(void* voice, BtEdbKick* self) {
-  g_signal_emit_by_name(self, "gstbt-ui-custom-gfx-invalidated", 0);
+// Called with slots_lock held.
+static void slots_publish(BtEdbKick* self, BtEdbSlotBank* bank) {
+  const guintptr old = __atomic_exchange_n(&self->slots_middle, (guintptr)bank | SLOTS_FRESH, __ATOMIC_ACQ_REL);
+  btedb_slot_bank_free((BtEdbSlotBank*)(old & ~SLOTS_FRESH));
+  self->slots_latest = bank;
+}
+
+// Called with slots_lock held.
+static BtEdbSlotBank* slots_copy_latest(BtEdbKick* self, guint min_slots) {
+  if (self->slots_latest)
+    return btedb_slot_bank_copy(self->slots_latest, min_slots);
+  else
+    return btedb_slot_bank_new(min_slots, MAX_VOICES);
+}
+
+// Store the voices' current settings into a slot, numbered from 1.
+static void slots_capture(BtEdbKick* self, guint slot) {
+  if (slot == 0)
+    return;
+  
+  BtEdbKickParams params[MAX_VOICES];
+  for (guint i = 0; i < MAX_VOICES; ++i)
+    btedb_kickv_get_params(self->voices[i], &params[i]);
+
+  g_mutex_lock(&self->slots_lock);
+  BtEdbSlotBank* const bank = slots_copy_latest(self, slot);
+  for (guint i = 0; i < MAX_VOICES; ++i)
+    btedb_slot_bank_set(bank, slot-1, i, &params[i]);
+  slots_publish(self, bank);
+  g_mutex_unlock(&self->slots_lock);
+}
+
+// Compile a comma-separated list of presets into slots, starting from slot 1.
+//
+// Each preset is loaded into a scratch machine rather than this one, so that the current sound isn't disturbed.
+static void slots_compile_presets(BtEdbKick* self, const gchar* presets) {
+  GstElement* const scratch = g_object_ref_sink(g_object_new(btedb_kick_get_type(), NULL));
+  if (!GST_IS_PRESET(scratch)) {
+    GST_WARNING_OBJECT(self, "Presets aren't supported, so can't be stored in slots");
+    gst_object_unref(scratch);
+    return;
+  }
+  
+  gchar** const names = g_strsplit(presets, ",", MAX_SLOTS);
+  const guint count = g_strv_length(names);
+  BtEdbKickParams* const params = g_new(BtEdbKickParams, count * MAX_VOICES);
+  gboolean* const loaded = g_new0(gboolean, count);
+  
+  for (guint slot = 0; slot < count; ++slot) {
+    const gchar* const name = g_strstrip(names[slot]);
+    if (*name == 0)
+      continue;
+    
+    if (!gst_preset_load_preset(GST_PRESET(scratch), name)) {
+      GST_WARNING_OBJECT(self, "Couldn't load preset '%s' for slot %u", name, slot+1);
+      continue;
+    }
+
+    for (guint i = 0; i < MAX_VOICES; ++i)
+      btedb_kickv_get_params(((BtEdbKick*)scratch)->voices[i], &params[slot * MAX_VOICES + i]);
+
+    loaded[slot] = TRUE;
+  }
+
+  gst_object_unref(scratch);
+
+  g_mutex_lock(&self->slots_lock);
+  BtEdbSlotBank* const bank = slots_copy_latest(self, count);
+  for (guint slot = 0; slot < count; ++slot) {
+    if (loaded[slot]) {
+      for (guint i = 0; i < MAX_VOICES; ++i)
+        btedb_slot_bank_set(bank, slot, i, &params[slot * MAX_VOICES + i]);
+    }
+  }
+  slots_publish(self, bank);
+  g_mutex_unlock(&self->slots_lock);
+
+  g_free(loaded);
+  g_free(params);
+  g_strfreev(names);
+}
+
+static void slots_load(BtEdbKick* self, const gchar* path) {
+  g_free(self->slot_bank_path);
+  self->slot_bank_path = g_strdup(path);
+
+  if (!path)
+    return;
+  
+  GError* error = NULL;
+  BtEdbSlotBank* const bank = btedb_slot_bank_load(path, MAX_VOICES, &error);
+  if (!bank) {
+    GST_WARNING_OBJECT(self, "Couldn't load slot bank: %s", error->message);
+    g_error_free(error);
+    return;
+  }
+
+  g_mutex_lock(&self->slots_lock);
+  slots_publish(self, bank);
+  g_mutex_unlock(&self->slots_lock);
+}
+
+static void slots_save(BtEdbKick* self, const gchar* path) {
+  if (!path)
+    return;
+  
+  GError* error = NULL;
+  g_mutex_lock(&self->slots_lock);
+  if (self->slots_latest && !btedb_slot_bank_save(self->slots_latest, path, &error)) {
+    GST_WARNING_OBJECT(self, "Couldn't save slot bank: %s", error->message);
+    g_error_free(error);
+  }
+  g_mutex_unlock(&self->slots_lock);
 }
 
 static void set_property (GObject* object, guint prop_id, const GValue* value, GParamSpec* pspec) {
   BtEdbKick* self = (BtEdbKick*)object;
-  g_assert(self->props);
-  btedb_properties_simple_set(self->props, pspec, value);
+
+  switch (prop_id) {
+  case PROP_SLOT_CAPTURE:
+    slots_capture(self, g_value_get_uint(value));
+    break;
+  case PROP_SLOT_PRESETS:
+    if (g_value_get_string(value))
+      slots_compile_presets(self, g_value_get_string(value));
+    break;
+  case PROP_SLOT_BANK:
+    slots_load(self, g_value_get_string(value));
+    break;
+  case PROP_SLOT_BANK_SAVE:
+    slots_save(self, g_value_get_string(value));
+    break;
+  default:
+    g_assert(self->props);
+    btedb_properties_simple_set(self->props, pspec, value);
+  }
 }
 
 static void get_property (GObject * object, guint prop_id, GValue * value, GParamSpec * pspec) {
   BtEdbKick* self = (BtEdbKick*)object;
-  btedb_properties_simple_get(self->props, pspec, value);
+
+  switch (prop_id) {
+  case PROP_SLOT_BANK:
+    g_value_set_string(value, self->slot_bank_path);
+    break;
+  case PROP_ENVELOPE_SOURCE:
+    g_value_set_object(value, self->envelope_source);
+    break;
+  case PROP_PEAK_SOURCE:
+    g_value_set_object(value, self->peak_source);
+    break;
+  case PROP_RMS_SOURCE:
+    g_value_set_object(value, self->rms_source);
+    break;
+  default:
+    btedb_properties_simple_get(self->props, pspec, value);
+  }
 }
 
 static gboolean process(GstBtAudioSynth* synth, GstBuffer* gstbuf, GstMapInfo* info) {
   BtEdbKick* self = (BtEdbKick*)synth;
+
+  // Pick up the newest slot bank, if one has been published since the last block.
+  if (__atomic_load_n(&self->slots_middle, __ATOMIC_ACQUIRE) & SLOTS_FRESH) {
+    const guintptr middle =
+      __atomic_exchange_n(&self->slots_middle, (guintptr)self->slots_front, __ATOMIC_ACQ_REL);
+    self->slots_front = (BtEdbSlotBank*)(middle & ~SLOTS_FRESH);
+  }
+
+  const BtEdbSlotBank* const bank = self->slots_front;
+  const guint slot = self->slot;
+  const guint morph_slot = self->morph_slot;
+  const gfloat morph = self->morph;
+  const gboolean use_slot = bank && slot != 0 && btedb_slot_bank_is_set(bank, slot-1);
+  const gboolean use_morph = use_slot && morph != 0 && morph_slot != 0 && btedb_slot_bank_is_set(bank, morph_slot-1);
+
+  // Voices mix into the buffer, clearing it first if none has yet. If none renders anything, it's left for the
+  // base class to clear and flag as a gap.
+  const guint frames = self->parent.generate_samples_per_buffer;
+  gboolean mixing = FALSE;
+  gboolean audible = FALSE;
+  
+  for (int i = 0; i < self->children; ++i) {
+    const BtEdbKickParams* params = NULL;
+    
+    if (use_morph) {
+      btedb_kick_params_lerp(
+        &self->slots_morphed[i], btedb_slot_bank_get(bank, slot-1, i), btedb_slot_bank_get(bank, morph_slot-1, i),
+        morph);
+      params = &self->slots_morphed[i];
+    } else if (use_slot) {
+      params = btedb_slot_bank_get(bank, slot-1, i);
+    }
+    
+    audible |= btedb_kickv_process(
+      self->voices[i], gstbuf, info, self->parent.running_time, frames, self->parent.info.rate, params, &mixing);
+  }
+
+  // Publish the levels measured while rendering, so nothing downstream needs to analyse the output to follow
+  // the kick.
+  BtEdbLevelMeta* const meta = btedb_buffer_add_level_meta(gstbuf);
+  BtEdbKickLevels mix = {0, 0, 0};
+  
+  meta->voices = self->children;
   for (int i = 0; i < self->children; ++i) {
-    btedb_kickv_process(
-      self->voices[i], gstbuf, info, self->parent.running_time, self->parent.generate_samples_per_buffer,
-      self->parent.info.rate);
+    BtEdbKickLevels levels;
+    btedb_kickv_get_levels(self->voices[i], &levels);
+    meta->voice[i] = (BtEdbLevelMetaLevels){levels.envelope, levels.peak, levels.rms};
+    mix.envelope = MAX(mix.envelope, levels.envelope);
   }
 
-  return TRUE;
+  if (audible) {
+    const gfloat* const outbuf = (const gfloat*)info->data;
+    gfloat sum_sq = 0;
+    for (guint i = 0; i < frames; ++i) {
+      mix.peak = MAX(mix.peak, fabsf(outbuf[i]));
+      sum_sq += outbuf[i] * outbuf[i];
+    }
+    mix.rms = frames ? sqrtf(sum_sq / frames) : 0;
+  }
+
+  meta->mix = (BtEdbLevelMetaLevels){mix.envelope, mix.peak, mix.rms};
+  self->levels = mix;
+  
+  btedb_level_source_push(self->envelope_source, self->parent.running_time, mix.envelope);
+  btedb_level_source_push(self->peak_source, self->parent.running_time, mix.peak);
+  btedb_level_source_push(self->rms_source, self->parent.running_time, mix.rms);
+
+  // GstBtAudioSynth clears silent buffers and flags them as gaps, so downstream elements that honour GAP can skip
+  // them too.
+  return audible;
 }
 
+// Voices are held only through their parent link, so they're unparented here; without that, they'd never be freed.
 static void dispose(GObject* object) {
   BtEdbKick* self = (BtEdbKick*)object;
-  btedb_properties_simple_free(self->props);
-  self->props = 0;
-  g_signal_handlers_disconnect_by_func(self, on_voice_gfx_invalidated, self);
+  g_clear_pointer(&self->props, btedb_properties_simple_free);
+
+  if (self->gfx_invalidate) {
+    g_source_destroy(self->gfx_invalidate);
+    g_clear_pointer(&self->gfx_invalidate, g_source_unref);
+  }
+
+  for (int i = 0; i < MAX_VOICES; i++) {
+    if (self->voices[i]) {
+      gst_object_unparent((GstObject*)self->voices[i]);
+      self->voices[i] = NULL;
+    }
+  }
+  
+  G_OBJECT_CLASS(btedb_kick_parent_class)->dispose(object);
+}
+
+static void finalize(GObject* object) {
+  BtEdbKick* self = (BtEdbKick*)object;
+  btedb_slot_bank_free((BtEdbSlotBank*)(self->slots_middle & ~SLOTS_FRESH));
+  btedb_slot_bank_free(self->slots_front);
+  g_free(self->slot_bank_path);
+  gst_object_unref(self->envelope_source);
+  gst_object_unref(self->peak_source);
+  gst_object_unref(self->rms_source);
+  g_mutex_clear(&self->slots_lock);
+  G_OBJECT_CLASS(btedb_kick_parent_class)->finalize(object);
 }
 
 static void btedb_kick_class_init(BtEdbKickClass* const klass) {
@@ -150,6 +435,7 @@ static void btedb_kick_class_init(BtEdbKickClass* const klass) {
     aclass->set_property = set_property;
     aclass->get_property = get_property;
     aclass->dispose = dispose;
+    aclass->finalize = finalize;
 
     // Note: variables will not be set to default values unless G_PARAM_CONSTRUCT is given.
 /*    const GParamFlags flags =
@@ -160,10 +446,76 @@ static void btedb_kick_class_init(BtEdbKickClass* const klass) {
       g_param_spec_uint("oversample", "Oversample", "Oversample", 1, 64, 2, flags ^ GST_PARAM_CONTROLLABLE));*/
 
     // GstBtChildBin interface properties
-    guint idx = 1;
     g_object_class_install_property(
-      aclass, idx++,
+      aclass, PROP_CHILDREN,
       g_param_spec_ulong("children", "Children", "", 0, MAX_VOICES, 1, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    // Slots hold compiled voice settings that can be switched between, or morphed between, without recomputing
+    // anything. Slot 0 means the voices' own settings.
+    const GParamFlags flags = (GParamFlags)(G_PARAM_READWRITE | GST_PARAM_CONTROLLABLE | G_PARAM_STATIC_STRINGS);
+    
+    g_object_class_install_property(
+      aclass, PROP_SLOT,
+      g_param_spec_uint("slot", "Slot", "Slot", 0, MAX_SLOTS, 0, flags));
+
+    g_object_class_install_property(
+      aclass, PROP_MORPH_SLOT,
+      g_param_spec_uint("morph-slot", "Morph Slot", "Slot to morph towards", 0, MAX_SLOTS, 0, flags));
+
+    g_object_class_install_property(
+      aclass, PROP_MORPH,
+      g_param_spec_float("morph", "Morph", "Morph amount", 0, 1, 0, flags));
+
+    g_object_class_install_property(
+      aclass, PROP_SLOT_CAPTURE,
+      g_param_spec_uint("slot-capture", "Slot Capture", "Store the current settings in the given slot",
+                        0, MAX_SLOTS, 0, G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property(
+      aclass, PROP_SLOT_PRESETS,
+      g_param_spec_string("slot-presets", "Slot Presets", "Comma-separated presets to store in slots from 1",
+                          NULL, G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property(
+      aclass, PROP_SLOT_BANK,
+      g_param_spec_string("slot-bank", "Slot Bank", "Slot bank file to load",
+                          NULL, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property(
+      aclass, PROP_SLOT_BANK_SAVE,
+      g_param_spec_string("slot-bank-save", "Save Slot Bank", "Save the slots to a slot bank file",
+                          NULL, G_PARAM_WRITABLE | G_PARAM_STATIC_STRINGS));
+
+    // Levels of the mix over the last block. The voices have their own. The control sources follow the same
+    // values, so that other machines' properties can be bound to them.
+    const GParamFlags flags_level = (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+    
+    g_object_class_install_property(
+      aclass, PROP_ENVELOPE,
+      g_param_spec_float("envelope", "Envelope", "Amplitude envelope peak", 0, G_MAXFLOAT, 0, flags_level));
+    
+    g_object_class_install_property(
+      aclass, PROP_PEAK,
+      g_param_spec_float("peak", "Peak", "Output peak", 0, G_MAXFLOAT, 0, flags_level));
+    
+    g_object_class_install_property(
+      aclass, PROP_RMS,
+      g_param_spec_float("rms", "RMS", "Output RMS", 0, G_MAXFLOAT, 0, flags_level));
+
+    g_object_class_install_property(
+      aclass, PROP_ENVELOPE_SOURCE,
+      g_param_spec_object("envelope-source", "Envelope Source", "Control source following the envelope",
+                          GST_TYPE_CONTROL_SOURCE, flags_level));
+    
+    g_object_class_install_property(
+      aclass, PROP_PEAK_SOURCE,
+      g_param_spec_object("peak-source", "Peak Source", "Control source following the output peak",
+                          GST_TYPE_CONTROL_SOURCE, flags_level));
+    
+    g_object_class_install_property(
+      aclass, PROP_RMS_SOURCE,
+      g_param_spec_object("rms-source", "RMS Source", "Control source following the output RMS",
+                          GST_TYPE_CONTROL_SOURCE, flags_level));
   }
 
   {
@@ -192,6 +544,17 @@ static void btedb_kick_class_init(BtEdbKickClass* const klass) {
 static void btedb_kick_init(BtEdbKick* const self) {
   self->props = btedb_properties_simple_new((GObject*)self);
   btedb_properties_simple_add(self->props, "children", &self->children);
+  btedb_properties_simple_add(self->props, "slot", &self->slot);
+  btedb_properties_simple_add(self->props, "morph-slot", &self->morph_slot);
+  btedb_properties_simple_add(self->props, "morph", &self->morph);
+  btedb_properties_simple_add(self->props, "envelope", &self->levels.envelope);
+  btedb_properties_simple_add(self->props, "peak", &self->levels.peak);
+  btedb_properties_simple_add(self->props, "rms", &self->levels.rms);
+  g_mutex_init(&self->slots_lock);
+
+  self->envelope_source = g_object_ref_sink(g_object_new(btedb_level_source_get_type(), NULL));
+  self->peak_source = g_object_ref_sink(g_object_new(btedb_level_source_get_type(), NULL));
+  self->rms_source = g_object_ref_sink(g_object_new(btedb_level_source_get_type(), NULL));
 
   for (int i = 0; i < MAX_VOICES; i++) {
     BtEdbKickV* voice = g_object_new(btedb_kickv_get_type(), 0);
@@ -204,8 +567,10 @@ static void btedb_kick_init(BtEdbKick* const self) {
 
     self->voices[i] = voice;
   }
-    
-  g_signal_connect (self->voices[0], "gstbt-ui-custom-gfx-invalidated", G_CALLBACK (on_voice_gfx_invalidated), self);
+
+  self->gfx_invalidate = btedb_gfx_invalidate_new((GObject*)self);
+  g_source_attach(self->gfx_invalidate, NULL);
+  btedb_kickv_set_gfx_invalidate(self->voices[0], self->gfx_invalidate);
 }
 
 static void gstbt_ui_custom_gfx_interface_init(GstBtUiCustomGfxInterface *iface)
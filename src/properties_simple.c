@@ -107,6 +107,16 @@ gboolean btedb_properties_simple_set(const BtEdbPropertiesSimple* self, GParamSp
   return FALSE;
 }
 	
+void* btedb_properties_simple_get_var(const BtEdbPropertiesSimple* self, GParamSpec* pspec) {
+  for (guint i = 0; i < self->props->len; ++i) {
+	PspecVar* const pspec_var = &g_array_index(self->props, PspecVar, i);
+	
+	if (pspec_var->pspec == pspec)
+	  return pspec_var->var;
+  }
+  return NULL;
+}
+
 void btedb_properties_simple_add(BtEdbPropertiesSimple* self, const char* prop_name, void* var) {
   PspecVar pspec_var;
 
@@ -120,6 +130,7 @@ void btedb_properties_simple_add(BtEdbPropertiesSimple* self, const char* prop_n
 
 void btedb_properties_simple_free(BtEdbPropertiesSimple* self) {
   g_array_unref(self->props);
+  g_free(self);
 }
 
 BtEdbPropertiesSimple* btedb_properties_simple_new(GObject* owner) {
@@ -32,3 +32,6 @@ void btedb_properties_simple_add(BtEdbPropertiesSimple* self, const char* prop_n
 gboolean btedb_properties_simple_get(const BtEdbPropertiesSimple* self, GParamSpec* pspec, GValue* value);
 gboolean btedb_properties_simple_set(const BtEdbPropertiesSimple* self, GParamSpec* pspec, const GValue* value);
 
+// The variable a property was added with, or NULL if it wasn't.
+void* btedb_properties_simple_get_var(const BtEdbPropertiesSimple* self, GParamSpec* pspec);
+
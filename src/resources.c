@@ -0,0 +1,95 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "src/resources.h"
+#include "src/debug.h"
+#include <math.h>
+
+struct _BtEdbResources {
+  guint refcount;
+  gfloat* note_freqs[GSTBT_TONE_CONVERSION_COUNT];
+  gfloat* sine;
+};
+
+// Guards the shared instance, its reference count and the creation of its tables.
+static GMutex lock;
+static BtEdbResources* instance;
+
+BtEdbResources* btedb_resources_ref(void) {
+  g_mutex_lock(&lock);
+  if (!instance) {
+    instance = g_malloc0(sizeof(BtEdbResources));
+    GST_DEBUG("creating shared tables");
+  }
+  ++instance->refcount;
+  BtEdbResources* const result = instance;
+  g_mutex_unlock(&lock);
+  return result;
+}
+
+void btedb_resources_unref(BtEdbResources* self) {
+  g_mutex_lock(&lock);
+  g_assert(self == instance && self->refcount > 0);
+  
+  if (--self->refcount == 0) {
+    GST_DEBUG("releasing shared tables");
+    for (guint i = 0; i < GSTBT_TONE_CONVERSION_COUNT; ++i)
+      g_free(self->note_freqs[i]);
+    g_free(self->sine);
+    g_free(self);
+    instance = NULL;
+  }
+  
+  g_mutex_unlock(&lock);
+}
+
+const gfloat* btedb_resources_get_note_freqs(BtEdbResources* self, GstBtToneConversionTuning tuning) {
+  g_mutex_lock(&lock);
+  
+  if (!self->note_freqs[tuning]) {
+    gfloat* const table = g_new0(gfloat, BTEDB_NOTE_TABLE_SIZE);
+    GstBtToneConversion* const tones = gstbt_tone_conversion_new(tuning);
+    
+    // Note numbers hold an octave in the upper four bits and a tone from 1 to 12 in the lower ones.
+    for (guint note = GSTBT_NOTE_C_0; note <= GSTBT_NOTE_LAST; ++note) {
+      if ((note & 0xf) >= 1 && (note & 0xf) <= 12)
+        table[note] = (gfloat)gstbt_tone_conversion_translate_from_number(tones, note);
+    }
+    
+    g_object_unref(tones);
+    self->note_freqs[tuning] = table;
+  }
+
+  const gfloat* const result = self->note_freqs[tuning];
+  g_mutex_unlock(&lock);
+  return result;
+}
+
+const gfloat* btedb_resources_get_sine(BtEdbResources* self) {
+  g_mutex_lock(&lock);
+  
+  if (!self->sine) {
+    gfloat* const table = g_new(gfloat, BTEDB_KICK_SINE_TABLE_SIZE + 1);
+    btedb_kick_sine_table_fill(table);
+    self->sine = table;
+  }
+
+  const gfloat* const result = self->sine;
+  g_mutex_unlock(&lock);
+  return result;
+}
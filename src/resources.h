@@ -0,0 +1,46 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "src/core.h"
+#include "libbuzztrax-gst/musicenums.h"
+#include "libbuzztrax-gst/toneconversion.h"
+#include <glib-object.h>
+
+// Indexed by GstBtNote, including GSTBT_NOTE_NONE, which maps to 0Hz.
+#define BTEDB_NOTE_TABLE_SIZE (GSTBT_NOTE_LAST + 1)
+
+typedef struct _BtEdbResources BtEdbResources;
+
+/*
+  Read-only DSP tables shared by every voice of every machine in the process.
+
+  The first reference creates the shared instance and the last one releases it. Each table is built on first
+  request and kept until then, so request them outside of the streaming thread, i.e. at init, and hold on to the
+  pointer.
+*/
+BtEdbResources* btedb_resources_ref(void);
+void btedb_resources_unref(BtEdbResources* self);
+
+// Frequency of each note in the given tuning.
+const gfloat* btedb_resources_get_note_freqs(BtEdbResources* self, GstBtToneConversionTuning tuning);
+
+// Sine table for btedb_kick_sine, as filled by btedb_kick_sine_table_fill.
+const gfloat* btedb_resources_get_sine(BtEdbResources* self);
+
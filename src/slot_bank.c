@@ -0,0 +1,181 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#include "src/slot_bank.h"
+#include <string.h>
+
+#define BANK_MAGIC "BTEDBKSB"
+#define BANK_VERSION 2
+
+// 'params_layout' fingerprints BtEdbKickParams, so that a bank compiled for a different set of fields, or with
+// different coefficient formulas, is refused rather than read as garbage.
+typedef struct {
+  gchar magic[8];
+  guint32 version;
+  guint32 params_size;
+  guint32 params_layout;
+  guint32 voices;
+  guint32 slots;
+} BankHeader;
+
+// The parameter sets follow the header directly, in both memory and the file, followed by a byte per slot
+// that's set once the slot has been filled.
+G_STATIC_ASSERT(sizeof(BankHeader) % sizeof(gfloat) == 0);
+
+struct _BtEdbSlotBank {
+  GMappedFile* file;
+  gchar* data;
+  gsize size;
+  guint slots;
+  guint voices;
+  BtEdbKickParams* params;
+  guint8* filled;
+};
+
+#define PARAMS_FIELD(name) G_STRUCT_OFFSET(BtEdbKickParams, name)
+
+static const gsize params_fields[] = {
+  PARAMS_FIELD(tone_start), PARAMS_FIELD(tone_time), PARAMS_FIELD(tone_shape_a), PARAMS_FIELD(tone_shape_b),
+  PARAMS_FIELD(tone_shape_exp), PARAMS_FIELD(amp_time), PARAMS_FIELD(amp_shape_a), PARAMS_FIELD(amp_shape_b),
+  PARAMS_FIELD(amp_shape_exp), PARAMS_FIELD(tune), PARAMS_FIELD(noise_octaves), PARAMS_FIELD(noise_time),
+  PARAMS_FIELD(noise_shape_a), PARAMS_FIELD(noise_shape_b), PARAMS_FIELD(noise_shape_exp), PARAMS_FIELD(noise_vol),
+  PARAMS_FIELD(fundamental_vol), PARAMS_FIELD(overtone_vol), PARAMS_FIELD(overtone_vol_time),
+  PARAMS_FIELD(overtone_vol_shape_a), PARAMS_FIELD(overtone_vol_shape_b), PARAMS_FIELD(overtone_vol_shape_exp),
+  PARAMS_FIELD(overtone_freq_factor), PARAMS_FIELD(overtones), PARAMS_FIELD(volume), PARAMS_FIELD(retrigger_period),
+  PARAMS_FIELD(anticlick), PARAMS_FIELD(c_tone_start), PARAMS_FIELD(c_tone_time), PARAMS_FIELD(c_tone_shape_a),
+  PARAMS_FIELD(c_tone_shape_b), PARAMS_FIELD(c_tone_shape_exp), PARAMS_FIELD(c_amp_time), PARAMS_FIELD(c_amp_shape_a),
+  PARAMS_FIELD(c_amp_shape_b), PARAMS_FIELD(c_amp_shape_exp), PARAMS_FIELD(c_noise_time),
+  PARAMS_FIELD(c_noise_shape_a), PARAMS_FIELD(c_noise_shape_b), PARAMS_FIELD(c_noise_shape_exp),
+  PARAMS_FIELD(c_overtone_vol_time), PARAMS_FIELD(c_overtone_vol_shape_a), PARAMS_FIELD(c_overtone_vol_shape_b),
+  PARAMS_FIELD(c_overtone_vol_shape_exp), PARAMS_FIELD(c_retrigger_period), PARAMS_FIELD(c_tune),
+  PARAMS_FIELD(c_freq_start), PARAMS_FIELD(c_overtone_vols), PARAMS_FIELD(c_overtone_vols_sum),
+  PARAMS_FIELD(retrigger), PARAMS_FIELD(partials),
+  sizeof(BtEdbKickParams), BTEDB_KICK_OVERTONES, BTEDB_KICK_PARAMS_VERSION
+};
+
+// FNV-1a over the field offsets and the constants that shape the parameter set.
+static guint32 params_layout(void) {
+  guint32 hash = 2166136261u;
+  for (gsize i = 0; i < G_N_ELEMENTS(params_fields); ++i) {
+    guint64 value = params_fields[i];
+    for (guint byte = 0; byte < sizeof(value); ++byte) {
+      hash = (hash ^ (value & 0xff)) * 16777619u;
+      value >>= 8;
+    }
+  }
+  return hash;
+}
+
+static gsize bank_size(guint slots, guint voices) {
+  return sizeof(BankHeader) + sizeof(BtEdbKickParams) * slots * voices + slots;
+}
+
+BtEdbSlotBank* btedb_slot_bank_new(guint slots, guint voices) {
+  BtEdbSlotBank* result = g_malloc0(sizeof(BtEdbSlotBank));
+  result->size = bank_size(slots, voices);
+  result->data = g_malloc0(result->size);
+  result->slots = slots;
+  result->voices = voices;
+  result->params = (BtEdbKickParams*)(result->data + sizeof(BankHeader));
+  result->filled = (guint8*)(result->params + slots * voices);
+
+  BankHeader* const header = (BankHeader*)result->data;
+  memcpy(header->magic, BANK_MAGIC, sizeof(header->magic));
+  header->version = BANK_VERSION;
+  header->params_size = sizeof(BtEdbKickParams);
+  header->params_layout = params_layout();
+  header->voices = voices;
+  header->slots = slots;
+
+  return result;
+}
+
+BtEdbSlotBank* btedb_slot_bank_copy(const BtEdbSlotBank* self, guint min_slots) {
+  BtEdbSlotBank* result = btedb_slot_bank_new(MAX(self->slots, min_slots), self->voices);
+  memcpy(result->params, self->params, sizeof(BtEdbKickParams) * self->slots * self->voices);
+  memcpy(result->filled, self->filled, self->slots);
+  return result;
+}
+
+BtEdbSlotBank* btedb_slot_bank_load(const gchar* path, guint voices, GError** error) {
+  GMappedFile* file = g_mapped_file_new(path, FALSE, error);
+  if (!file)
+    return NULL;
+
+  const gsize size = g_mapped_file_get_length(file);
+  gchar* const data = g_mapped_file_get_contents(file);
+  const BankHeader* const header = (const BankHeader*)data;
+
+  if (size < sizeof(BankHeader) ||
+      memcmp(header->magic, BANK_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != BANK_VERSION ||
+      header->params_size != sizeof(BtEdbKickParams) ||
+      header->params_layout != params_layout() ||
+      header->voices != voices ||
+      size != bank_size(header->slots, header->voices)) {
+    g_set_error(error, G_FILE_ERROR, G_FILE_ERROR_INVAL, "'%s' isn't a slot bank written by this version", path);
+    g_mapped_file_unref(file);
+    return NULL;
+  }
+
+  BtEdbSlotBank* result = g_malloc0(sizeof(BtEdbSlotBank));
+  result->file = file;
+  result->data = data;
+  result->size = size;
+  result->slots = header->slots;
+  result->voices = header->voices;
+  result->params = (BtEdbKickParams*)(data + sizeof(BankHeader));
+  result->filled = (guint8*)(result->params + result->slots * result->voices);
+  return result;
+}
+
+gboolean btedb_slot_bank_save(const BtEdbSlotBank* self, const gchar* path, GError** error) {
+  return g_file_set_contents(path, self->data, self->size, error);
+}
+
+void btedb_slot_bank_free(BtEdbSlotBank* self) {
+  if (!self)
+    return;
+
+  if (self->file)
+    g_mapped_file_unref(self->file);
+  else
+    g_free(self->data);
+
+  g_free(self);
+}
+
+guint btedb_slot_bank_get_slots(const BtEdbSlotBank* self) {
+  return self->slots;
+}
+
+gboolean btedb_slot_bank_is_set(const BtEdbSlotBank* self, guint slot) {
+  return slot < self->slots && self->filled[slot];
+}
+
+const BtEdbKickParams* btedb_slot_bank_get(const BtEdbSlotBank* self, guint slot, guint voice) {
+  g_assert(slot < self->slots && voice < self->voices);
+  return &self->params[slot * self->voices + voice];
+}
+
+void btedb_slot_bank_set(BtEdbSlotBank* self, guint slot, guint voice, const BtEdbKickParams* params) {
+  g_assert(!self->file);
+  g_assert(slot < self->slots && voice < self->voices);
+  self->params[slot * self->voices + voice] = *params;
+  self->filled[slot] = TRUE;
+}
@@ -0,0 +1,45 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "src/voice.h"
+#include <glib-object.h>
+
+typedef struct _BtEdbSlotBank BtEdbSlotBank;
+
+/*
+  An immutable bank of compiled voice parameter sets, one set per voice for each slot.
+
+  The sets are stored back to back in the same layout as the bank file, so a bank loaded from a file is used
+  straight from the mapped file. Bank files are only meant to be read by the same build that wrote them; loading
+  fails if the parameter layout doesn't match.
+
+  Banks aren't modified once they've been handed to the streaming thread. To change a slot, copy the bank with
+  btedb_slot_bank_copy, set the slot on the copy and hand that over instead.
+*/
+BtEdbSlotBank* btedb_slot_bank_new(guint slots, guint voices);
+BtEdbSlotBank* btedb_slot_bank_copy(const BtEdbSlotBank* self, guint min_slots);
+BtEdbSlotBank* btedb_slot_bank_load(const gchar* path, guint voices, GError** error);
+gboolean btedb_slot_bank_save(const BtEdbSlotBank* self, const gchar* path, GError** error);
+void btedb_slot_bank_free(BtEdbSlotBank* self);
+
+guint btedb_slot_bank_get_slots(const BtEdbSlotBank* self);
+gboolean btedb_slot_bank_is_set(const BtEdbSlotBank* self, guint slot);
+const BtEdbKickParams* btedb_slot_bank_get(const BtEdbSlotBank* self, guint slot, guint voice);
+void btedb_slot_bank_set(BtEdbSlotBank* self, guint slot, guint voice, const BtEdbKickParams* params);
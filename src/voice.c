@@ -18,100 +18,143 @@
 
 #include "src/voice.h"
 #include "src/debug.h"
+#include "src/gfx_invalidate.h"
 #include "src/properties_simple.h"
+#include "src/resources.h"
 #include "libbuzztrax-gst/musicenums.h"
-#include "libbuzztrax-gst/toneconversion.h"
 #include "libbuzztrax-gst/ui.h"
 #include <gst/gstobject.h>
 #include <math.h>
-
-#define PINK_NOISE_OCTAVES 17
-#define OVERTONES 10
+#include <string.h>
 
 #define GFX_WIDTH 64
 #define GFX_HEIGHT 64
 
+// Published snapshots are exchanged through a single atomic int holding a slot index, plus this flag when the
+// slot holds a snapshot the streaming thread hasn't picked up yet.
+#define PARAMS_INDEX 0x3
+#define PARAMS_FRESH 0x4
+
+// Automated properties are followed in control steps rather than once per block. A block is split into at most
+// CONTROL_STEPS_MAX steps, of at least CONTROL_STEP_FRAMES each.
+#define CONTROL_STEP_FRAMES 64
+#define CONTROL_STEPS_MAX 64
+
+// Properties automated beyond this many are only updated once per block, from the values synced at its start.
+#define AUTOMATED_MAX 16
+
+// Which properties have control bindings is checked again after this much audio. Bindings added in between are
+// followed once per block until then.
+#define BOUND_SCAN_SECONDS 1
+
+// Overtones with a property each, which presets and patterns refer to. The gains of the rest are set together through
+// the array valued "overtones-upper" property, so they don't add a pattern column per overtone per voice.
+#define OVERTONES_SCALAR 10
+#define OVERTONES_UPPER (BTEDB_KICK_OVERTONES - OVERTONES_SCALAR)
+
+// Distinct parameter set members, and so the most values one sync can set.
+#define SYNCED_MAX (sizeof(BtEdbKickParams) / sizeof(gfloat))
+
+// Note-ons remembered for picking notes up again after a seek.
+#define NOTE_HISTORY_SIZE 64
+
+// How far back the note control binding is searched for the note sounding at a new position.
+#define NOTE_SCAN_SECONDS 30
+
+// A note started at the given stream sample offset, with the given noise seed.
+typedef struct {
+  guint64 offset;
+  gfloat freq;
+  guint32 seed;
+} NoteOn;
+
+// A value set by syncing control bindings on the streaming thread, as stored in the parameter set.
+typedef struct {
+  gsize offset;
+  guint32 bits;
+} SyncedValue;
+
+// A controllable float property that's stored in the parameter set, so can be followed in control steps.
+typedef struct {
+  GParamSpec* pspec;
+  gsize offset;
+} Automatable;
+
+// Values of an automated property for each control step of the current block, and the coefficients compiled from
+// them. 'coef_offset' is -1 if the property has no coefficient of its own.
+typedef struct {
+  gsize offset;
+  gint coef_offset;
+  gfloat values[CONTROL_STEPS_MAX];
+  gfloat coefs[CONTROL_STEPS_MAX];
+} Automation;
+
 struct _BtEdbKickV
 {
   GstObject parent;
 
+  // Writer side. 'params_staged' holds the property values; 'params_lock' serializes writers only.
+  GMutex params_lock;
+  BtEdbKickParams params_staged;
+  gint params_back;
+
+  // Shared between writers and the streaming thread. Only ever accessed atomically. 'sync_thread' is the streaming
+  // thread while it syncs control bindings, so that set_property can tell it mustn't block.
+  gint params_middle;
+  gint note_pending;
+  GThread* sync_thread;
+
+  // Streaming thread side.
+  BtEdbKickParams params[3];
+  gint params_front;
+  BtEdbKickParams params_stepped;
+  Automation automation[AUTOMATED_MAX];
+  gboolean automated_overflow_logged;
+
+  // Indices into 'automatable' of the properties found to have control bindings, and the frames rendered since
+  // they were looked for. A full scan takes a lookup per property, so is only done now and again.
+  guint bound[AUTOMATED_MAX];
+  guint bound_len;
+  guint64 bound_scan_frames;
+  gboolean bound_scan_due;
+
+  // Values synced since the start of the last block. They're copied to 'params_staged' when 'params_lock' is free,
+  // and until then applied again over any snapshot picked up, so that snapshots published without them don't undo
+  // them.
+  SyncedValue synced[SYNCED_MAX];
+  guint synced_len;
+
   GstBtNote note;
-  gfloat tone_start;
-  gfloat tone_time;
-  gfloat tone_shape_a;
-  gfloat tone_shape_b;
-  gfloat tone_shape_exp;
-  gfloat amp_time;
-  gfloat amp_shape_a;
-  gfloat amp_shape_b;
-  gfloat amp_shape_exp;
-  gfloat tune;
-  gfloat noise_octaves;
-  gfloat noise_time;
-  gfloat noise_shape_a;
-  gfloat noise_shape_b;
-  gfloat noise_shape_exp;
-  gfloat noise_vol;
-  gfloat fundamental_vol;
-  gfloat overtone_vol;
-  gfloat overtone_vol_time;
-  gfloat overtone_vol_shape_a;
-  gfloat overtone_vol_shape_b;
-  gfloat overtone_vol_shape_exp;
-  gfloat overtone_freq_factor;
-  gfloat overtone0;
-  gfloat overtone1;
-  gfloat overtone2;
-  gfloat overtone3;
-  gfloat overtone4;
-  gfloat overtone5;
-  gfloat overtone6;
-  gfloat overtone7;
-  gfloat overtone8;
-  gfloat overtone9;
-  gfloat volume;
-  guint retrigger;
-  gfloat retrigger_period;
-  gfloat anticlick;
-
-  gfloat c_tone_start;
-  gfloat c_tone_time;
-  gfloat c_tone_shape_a;
-  gfloat c_tone_shape_b;
-  gfloat c_tone_shape_exp;
-  gfloat c_amp_time;
-  gfloat c_amp_shape_a;
-  gfloat c_amp_shape_b;
-  gfloat c_amp_shape_exp;
-  gfloat c_noise_time;
-  gfloat c_noise_shape_a;
-  gfloat c_noise_shape_b;
-  gfloat c_noise_shape_exp;
-  gfloat c_overtone_vol_time;
-  gfloat c_overtone_vol_shape_a;
-  gfloat c_overtone_vol_shape_b;
-  gfloat c_overtone_vol_shape_exp;
-  gfloat c_retrigger_period;
-  
-  guint retrig_count;
-  gfloat retrig_period_cur;
-  guint32 lcg_state[PINK_NOISE_OCTAVES];
-  gfloat lcg_noise[PINK_NOISE_OCTAVES];
-  gfloat noise;
-  gint16 pink_accum;
-  gfloat accum[OVERTONES + 1];
-  gfloat seconds;
-  GstClockTime running_time;
   GstClockTime time_off;
+
+  // Note-ons in stream order, oldest first, as a ring. 'next_offset' is where the next block should start if
+  // there's been no seek.
+  NoteOn note_history[NOTE_HISTORY_SIZE];
+  guint note_history_first;
+  guint note_history_len;
+  guint64 next_offset;
+  // Seeds notes played when buffers carry no offset.
+  guint32 note_count;
+
+  // Levels in 'dsp' are measured over the last block by the streaming thread, and read from any thread. A stale
+  // value is harmless.
+  BtEdbKickState dsp;
+  
   BtEdbPropertiesSimple* props;
-  GstBtToneConversion* tones;
+  GArray* automatable;
+  BtEdbResources* resources;
+  const gfloat* note_freqs;
 
+  // Raised when a property changes, if the voice's graphics are shown. Set once, before the voice is used.
+  GSource* gfx_invalidate;
   GstBtUiCustomGfxResponse gfx;
   guint32 gfx_data[GFX_WIDTH * GFX_HEIGHT];
 };
 
 static void gstbt_ui_custom_gfx_interface_init(GstBtUiCustomGfxInterface* iface);
 
+static guint prop_overtones_upper;
+
 G_DEFINE_TYPE_WITH_CODE(BtEdbKickV, btedb_kickv, GST_TYPE_OBJECT,
                         G_IMPLEMENT_INTERFACE(GSTBT_UI_TYPE_CUSTOM_GFX, gstbt_ui_custom_gfx_interface_init))
 
@@ -119,169 +162,335 @@ G_DEFINE_TYPE_WITH_CODE(BtEdbKickV, btedb_kickv, GST_TYPE_OBJECT,
   return powf(10.0f, db / 20.0f);
   }*/
 
-static const guint lcg_multiplier = 1103515245;
-static const guint lcg_increment = 12345;
+void btedb_kickv_get_levels(BtEdbKickV* self, BtEdbKickLevels* levels) {
+  *levels = self->dsp.levels;
+}
+
+void btedb_kickv_set_gfx_invalidate(BtEdbKickV* self, GSource* source) {
+  g_assert(!self->gfx_invalidate);
+  self->gfx_invalidate = g_source_ref(source);
+}
+
+// Values synced from control bindings reach 'params_staged' without being compiled, so copies are compiled here.
+void btedb_kickv_get_params(BtEdbKickV* self, BtEdbKickParams* params) {
+  g_mutex_lock(&self->params_lock);
+  *params = self->params_staged;
+  g_mutex_unlock(&self->params_lock);
+  btedb_kick_params_compile(params);
+}
 
 static inline gfloat logscale(gfloat min, gfloat max, gfloat base, gfloat x) {
   gfloat logbase = logf(base);
   return logf(MAX(1,x-min)) / logbase / (logf(max) / logbase);
 }
 
-// Return a random float between -1.0 and 1.0.
-// https://www.pcg-random.org/pdf/hmc-cs-2014-0905.pdf
-static inline gfloat lcg(guint32* state) {
-  *state = (*state + lcg_increment) * lcg_multiplier;
+// GLib only gained g_atomic_int_exchange in 2.74.
+static inline gint atomic_exchange(gint* atomic, gint value) {
+  return __atomic_exchange_n(atomic, value, __ATOMIC_ACQ_REL);
+}
 
-  // Hexadecimal floating point literals are a means to define constant real values that can be exactly
-  // represented as a floating point value.
-  //
-  // https://www.pcg-random.org/posts/bounded-rands.html
-  // https://www.exploringbinary.com/hexadecimal-floating-point-constants/
-  // pg 57-58: http://www.open-std.org/jtc1/sc22/wg14/www/docs/n1256.pdf
-  return -1.0f + 0x2.0p-32 * *state;
+void btedb_kickv_note_off(BtEdbKickV* self, GstClockTime time) {
+  self->time_off = time;
 }
 
-static inline gfloat lerp(gfloat a, gfloat b, gfloat alpha) {
-  return a + (b-a) * MAX(MIN(alpha,1),0);
+// Look for the automatable properties that have control bindings.
+static void bound_scan(BtEdbKickV* const self) {
+  self->bound_len = 0;
+  self->bound_scan_frames = 0;
+  self->bound_scan_due = FALSE;
+  
+  for (guint i = 0; i < self->automatable->len; ++i) {
+    const Automatable* const a = &g_array_index(self->automatable, Automatable, i);
+    GstControlBinding* const binding = gst_object_get_control_binding((GstObject*)self, a->pspec->name);
+    if (!binding)
+      continue;
+    gst_object_unref(binding);
+
+    if (self->bound_len == AUTOMATED_MAX) {
+      if (!self->automated_overflow_logged) {
+        GST_DEBUG_OBJECT(self, "more than %d properties automated; '%s' and any after it follow once per block",
+                         AUTOMATED_MAX, a->pspec->name);
+        self->automated_overflow_logged = TRUE;
+      }
+      break;
+    }
+    
+    self->bound[self->bound_len++] = i;
+  }
 }
 
-static inline gfloat plerp(gfloat a, gfloat b, gfloat alpha, gfloat power) {
-  return powf(a + (b-a) * MAX(MIN(alpha,1),0), power);
+// Fetch per-step values of automated properties for the block starting at 'timestamp'. Returns how many properties
+// were fetched. Any whose control source can't supply a value array keep the value synced for the whole block.
+static guint automation_fetch(BtEdbKickV* const self, GstClockTime timestamp, GstClockTime interval, guint steps,
+                              guint frames, guint rate) {
+  if (self->bound_scan_due || self->bound_scan_frames >= (guint64)BOUND_SCAN_SECONDS * rate)
+    bound_scan(self);
+  self->bound_scan_frames += frames;
+  
+  guint count = 0;
+  guint kept = 0;
+  
+  for (guint i = 0; i < self->bound_len; ++i) {
+    const Automatable* const a = &g_array_index(self->automatable, Automatable, self->bound[i]);
+    GstControlBinding* const binding = gst_object_get_control_binding((GstObject*)self, a->pspec->name);
+    if (!binding)
+      continue;
+    self->bound[kept++] = self->bound[i];
+
+    Automation* const dst = &self->automation[count];
+    if (!gst_control_binding_is_disabled(binding) &&
+        gst_control_binding_get_value_array(binding, timestamp, interval, steps, dst->values)) {
+      dst->offset = a->offset;
+      dst->coef_offset = btedb_kick_params_compile_setting(a->offset, dst->values, dst->coefs, steps);
+      ++count;
+    }
+
+    gst_object_unref(binding);
+  }
+
+  // Bindings removed since the last scan are dropped straight away.
+  self->bound_len = kept;
+  return count;
 }
 
-static inline gfloat decay(gfloat t, gfloat start, gfloat end, gfloat a, gfloat b, gfloat decay_time, gfloat power) {
-  return start + (end - start) * (1 - expf(-t / plerp(a, b, t / decay_time, power)));
+// Render the block in control steps, with the automated properties' values for each step.
+static gboolean render_automated(BtEdbKickV* const self, const BtEdbKickParams* const p, GstClockTime timestamp,
+                                 gfloat* const out, guint frames, guint rate) {
+  const guint step_frames = MAX(CONTROL_STEP_FRAMES, (frames + CONTROL_STEPS_MAX - 1) / CONTROL_STEPS_MAX);
+  const guint steps = (frames + step_frames - 1) / step_frames;
+  const guint count =
+    automation_fetch(self, timestamp, gst_util_uint64_scale_int(step_frames, GST_SECOND, rate), steps, frames, rate);
+
+  if (count == 0)
+    return btedb_kick_render(&self->dsp, p, out, frames, rate);
+
+  BtEdbKickParams* const stepped = &self->params_stepped;
+  *stepped = *p;
+
+  gboolean audible = FALSE;
+  BtEdbKickLevels levels = {0, 0, 0};
+  gfloat sum_sq = 0;
+  
+  for (guint step = 0; step < steps; ++step) {
+    const guint offset = step * step_frames;
+    const guint n = MIN(step_frames, frames - offset);
+
+    for (guint i = 0; i < count; ++i) {
+      const Automation* const a = &self->automation[i];
+      *(gfloat*)((gchar*)stepped + a->offset) = a->values[step];
+      if (a->coef_offset >= 0)
+        *(gfloat*)((gchar*)stepped + a->coef_offset) = a->coefs[step];
+    }
+    btedb_kick_params_compile_derived(stepped);
+    
+    audible |= btedb_kick_render(&self->dsp, stepped, out + offset, n, rate);
+
+    levels.envelope = MAX(levels.envelope, self->dsp.levels.envelope);
+    levels.peak = MAX(levels.peak, self->dsp.levels.peak);
+    sum_sq += self->dsp.levels.rms * self->dsp.levels.rms * n;
+  }
+
+  levels.rms = sqrtf(sum_sq / frames);
+  self->dsp.levels = levels;
+  
+  return audible;
 }
 
-void btedb_kickv_note_off(BtEdbKickV* self, GstClockTime time) {
-  self->time_off = time;
+static void note_history_push(BtEdbKickV* const self, const NoteOn* const note) {
+  if (self->note_history_len == NOTE_HISTORY_SIZE) {
+    self->note_history_first = (self->note_history_first + 1) % NOTE_HISTORY_SIZE;
+    --self->note_history_len;
+  }
+  
+  const guint idx = (self->note_history_first + self->note_history_len++) % NOTE_HISTORY_SIZE;
+  self->note_history[idx] = *note;
 }
 
-static void btedb_kickv_note_on(BtEdbKickV* self, gfloat seconds, guint retrig_cnt) {
-  self->seconds = seconds;
-  self->retrig_count = retrig_cnt;
-  self->retrig_period_cur = self->c_retrigger_period;
-  //self->accum = 0;
+// Search the note control binding for the last note-on before 'offset', at 'timestamp', going back a block of
+// 'block_frames' at a time (the pattern's tick, for a voice driven from one) but no further back than 'floor'.
+static gboolean note_binding_find(BtEdbKickV* const self, guint64 offset, GstClockTime timestamp, guint block_frames,
+                                  guint rate, guint64 floor, NoteOn* const found) {
+  GstControlBinding* const binding = gst_object_get_control_binding((GstObject*)self, "note");
+  if (!binding)
+    return FALSE;
+
+  gboolean result = FALSE;
+  const guint64 span = MIN(offset - floor, (guint64)NOTE_SCAN_SECONDS * rate);
+  
+  for (guint64 back = block_frames; back <= span && !result; back += block_frames) {
+    const GstClockTime delta = gst_util_uint64_scale_int(back, GST_SECOND, rate);
+    if (delta > timestamp)
+      break;
+    
+    GValue* const value = gst_control_binding_get_value(binding, timestamp - delta);
+    if (!value)
+      continue;
+
+    // Note-offs don't silence a kick, so the search carries on past them.
+    const GstBtNote note = (GstBtNote)g_value_get_enum(value);
+    if (note != GSTBT_NOTE_NONE && note != GSTBT_NOTE_OFF) {
+      const gfloat freq = note < BTEDB_NOTE_TABLE_SIZE ? self->note_freqs[note] : 0;
+      *found = (NoteOn){offset - back, freq, (guint32)(offset - back)};
+      self->note = note;
+      result = TRUE;
+    }
+    
+    g_value_unset(value);
+    g_free(value);
+  }
+
+  gst_object_unref(binding);
+  return result;
 }
 
-static inline gfloat amp(const BtEdbKickV* const self, const gfloat seconds) {
-  return decay(seconds, 1, 0, self->c_amp_shape_a, self->c_amp_shape_b, self->c_amp_time, self->c_amp_shape_exp);
+// Continue from 'offset' after a seek or loop, with whichever note would be sounding there.
+//
+// Notes after the new position are forgotten; if they're still in the song, they'll be played and remembered again
+// on the way back to them. Notes between the new position and the last one remembered before it, which were never
+// played, are found from the note control binding if there is one. Without one, a seek ahead of anything played so
+// far continues the last note played.
+static void reposition(BtEdbKickV* const self, const BtEdbKickParams* const p, guint64 offset,
+                       GstClockTime timestamp, guint block_frames, guint rate) {
+  // Playback starting or jumping is when bindings are most likely to have changed.
+  self->bound_scan_due = TRUE;
+
+  const NoteOn* remembered = NULL;
+  while (self->note_history_len > 0) {
+    const guint newest = (self->note_history_first + self->note_history_len - 1) % NOTE_HISTORY_SIZE;
+    if (self->note_history[newest].offset <= offset) {
+      remembered = &self->note_history[newest];
+      break;
+    }
+    --self->note_history_len;
+  }
+
+  NoteOn found;
+  const NoteOn* note = remembered;
+  if (GST_CLOCK_TIME_IS_VALID(timestamp) &&
+      note_binding_find(self, offset, timestamp, block_frames, rate, remembered ? remembered->offset : 0, &found))
+    note = &found;
+  
+  if (note)
+    btedb_kick_note_seek(&self->dsp, p, note->freq, note->seed, (gdouble)(offset - note->offset) / rate, rate);
+  else
+    btedb_kick_note_cut(&self->dsp);
 }
 
-static inline gfloat freq(const BtEdbKickV* const self, gfloat seconds, gfloat start, gfloat end) {
-  return decay(seconds, start, end, self->c_tone_shape_a, self->c_tone_shape_b, self->c_tone_time,
-               self->c_tone_shape_exp);
+// Copy values synced so far to the writer side, if no writer holds it. Returns FALSE if one did.
+static gboolean synced_flush(BtEdbKickV* const self) {
+  if (!g_mutex_trylock(&self->params_lock))
+    return FALSE;
+
+  for (guint i = 0; i < self->synced_len; ++i) {
+    const SyncedValue* const synced = &self->synced[i];
+    memcpy((gchar*)&self->params_staged + synced->offset, &synced->bits, sizeof(synced->bits));
+  }
+  
+  g_mutex_unlock(&self->params_lock);
+  return TRUE;
 }
 
-static inline gfloat osc(gfloat* accum, gfloat timedelta, gfloat freqval, gfloat harmonic) {
-  gfloat result = sin(*accum);
-  *accum += 2 * G_PI * timedelta * freqval * (harmonic+1);
-  return result;
+// Set a property from gst_object_sync_values on the streaming thread, which mustn't wait for writers: the value goes
+// straight into the snapshot being rendered, and is queued for the writer side. Returns FALSE for properties that
+// aren't in the parameter set.
+static gboolean synced_set(BtEdbKickV* const self, GParamSpec* const pspec, const GValue* const value) {
+  const gchar* const var = btedb_properties_simple_get_var(self->props, pspec);
+  if (var < (const gchar*)&self->params_staged || var >= (const gchar*)(&self->params_staged + 1))
+    return FALSE;
+
+  SyncedValue synced = { var - (const gchar*)&self->params_staged, 0 };
+  if (pspec->value_type == G_TYPE_FLOAT) {
+    const gfloat f = g_value_get_float(value);
+    memcpy(&synced.bits, &f, sizeof(f));
+  } else if (pspec->value_type == G_TYPE_UINT) {
+    synced.bits = g_value_get_uint(value);
+  } else {
+    return FALSE;
+  }
+
+  guint i = 0;
+  while (i < self->synced_len && self->synced[i].offset != synced.offset)
+    ++i;
+  self->synced[i] = synced;
+  self->synced_len = MAX(self->synced_len, i + 1);
+
+  memcpy((gchar*)&self->params[self->params_front] + synced.offset, &synced.bits, sizeof(synced.bits));
+  return TRUE;
 }
 
-void btedb_kickv_process(
+gboolean btedb_kickv_process(
   BtEdbKickV* const self, GstBuffer* const gstbuf, GstMapInfo* info, GstClockTime running_time, guint requested_frames,
-  guint rate) {
+  guint rate, const BtEdbKickParams* const params, gboolean* const mixing) {
   // Necessary to update parameters from pattern.
   //
   // The parent machine is responsible for delgating process to any children it has; the pattern control group
   // won't have called it for each voice. Although maybe it should?
-  gst_object_sync_values((GstObject*)self, GST_BUFFER_PTS(gstbuf));
+  const gboolean controlled = gst_object_has_active_control_bindings((GstObject*)self);
 
-  const gdouble tune = powf(2, self->tune/12.0f);
-  const gfloat freq_note = (gfloat)gstbt_tone_conversion_translate_from_number(self->tones, self->note) * tune;
-  const gfloat freq_start = self->c_tone_start * tune;
-
-  gfloat* outbuf = (gfloat*)(info->data);
-  
-  const gfloat timedelta = 1.0f/rate;
-
-  const gfloat overtone_vols[OVERTONES] = {
-    self->overtone0 * self->overtone_vol,
-    self->overtone1 * self->overtone_vol,
-    self->overtone2 * self->overtone_vol,
-    self->overtone3 * self->overtone_vol,
-    self->overtone4 * self->overtone_vol,
-    self->overtone5 * self->overtone_vol,
-    self->overtone6 * self->overtone_vol,
-    self->overtone7 * self->overtone_vol,
-    self->overtone8 * self->overtone_vol,
-    self->overtone9 * self->overtone_vol
-  };
-
-  for (guint i = 0; i < requested_frames; ++i) {
-    gfloat fundamental;
-    gfloat freqval = freq(self, self->seconds, freq_start, freq_note);
-    
-    if (self->fundamental_vol != 0.0) {
-      fundamental = osc(&self->accum[0], timedelta, freqval, 0) * self->fundamental_vol;
-    } else {
-      fundamental = 0.0f;
-    }
+  const gboolean flushed = self->synced_len > 0 && synced_flush(self);
 
-    gfloat otones = 0;
+  // Pick up the newest parameter snapshot, if one has been published since the last block.
+  if (g_atomic_int_get(&self->params_middle) & PARAMS_FRESH)
+    self->params_front = atomic_exchange(&self->params_middle, self->params_front) & PARAMS_INDEX;
 
-    if (self->overtone_vol != 0.0) {
-      for (guint j = 0; j < OVERTONES; ++j)
-        // Note: self->overtone_vols already pre-multiplied by overtone_vol above.
-        if (overtone_vols[j] != 0.0)
-          otones += osc(&self->accum[j+1], timedelta, freqval, (j+1)*self->overtone_freq_factor)
-            * overtone_vols[j]
-            * decay(self->seconds, 1, 0, self->c_overtone_vol_shape_a, self->c_overtone_vol_shape_b,
-                    self->c_overtone_vol_time, self->c_overtone_vol_shape_exp);
-    }
+  BtEdbKickParams* const front = &self->params[self->params_front];
+  for (guint i = 0; i < self->synced_len; ++i)
+    memcpy((gchar*)front + self->synced[i].offset, &self->synced[i].bits, sizeof(self->synced[i].bits));
+  if (flushed)
+    self->synced_len = 0;
 
-    outbuf[i] = (fundamental + otones) * amp(self, self->seconds);
-    
-    // https://www.firstpr.com.au/dsp/pink-noise/#Voss-McCartney
-    if (self->noise_vol != 0.0) {
-      // Add base white noise on each sample. Otherwise, the highest frequency noise is only every other sample.
-      self->noise -= self->lcg_noise[0];
-      self->lcg_noise[0] = lcg(&self->lcg_state[0]);
-      self->noise += self->lcg_noise[0];
-
-      // Subtracting the old noise value from an accumulated noise value avoids having to sum x stored noise values
-      // each sample. As a result, some inertia is maintained if sweeping the octave value, but not a big deal.
-      //
-      // Select the noise state to update by counting trailing zeroes in the noise accumulator.
-      guint update_idx = __builtin_ctz(self->pink_accum)+1;
-      self->noise -= self->lcg_noise[update_idx];
-      if (update_idx <= self->noise_octaves) {
-        gfloat gain = MIN(1.0f, self->noise_octaves - (gfloat)(update_idx+1));
-        self->lcg_noise[update_idx] = lcg(&self->lcg_state[update_idx]) * gain;
-        self->noise += self->lcg_noise[update_idx];
-      } else {
-        self->lcg_noise[update_idx] = 0;
-      }
-
-      ++self->pink_accum;
+  if (controlled) {
+    g_atomic_pointer_set(&self->sync_thread, g_thread_self());
+    gst_object_sync_values((GstObject*)self, GST_BUFFER_PTS(gstbuf));
+    g_atomic_pointer_set(&self->sync_thread, NULL);
+  }
 
-      outbuf[i] +=
-        (self->noise / self->noise_octaves) *
-        decay(self->seconds, 1, 0, self->c_noise_shape_a, self->c_noise_shape_b, self->c_noise_time,
-              self->c_noise_shape_exp) *
-        self->noise_vol;
-    }
+  if (self->synced_len > 0)
+    btedb_kick_params_compile(front);
+
+  const BtEdbKickParams* const p = params ? params : front;
+
+  // Buffer offsets count samples from the start of the stream, so a block that doesn't follow on from the last one
+  // means a seek.
+  const gboolean positioned = GST_BUFFER_OFFSET_IS_VALID(gstbuf);
+  const guint64 offset = GST_BUFFER_OFFSET(gstbuf);
+  if (positioned && offset != self->next_offset)
+    reposition(self, p, offset, GST_BUFFER_PTS(gstbuf), requested_frames, rate);
+  self->next_offset = offset + requested_frames;
+
+  const GstBtNote note = (GstBtNote)atomic_exchange(&self->note_pending, GSTBT_NOTE_NONE);
+  if (note == GSTBT_NOTE_OFF) {
+    btedb_kickv_note_off(self, running_time);
+  } else if (note != GSTBT_NOTE_NONE) {
+    const gfloat freq = note < BTEDB_NOTE_TABLE_SIZE ? self->note_freqs[note] : 0;
+    // Seeding by position gives each note its own noise, and the same noise again when it's picked up after a seek.
+    const NoteOn note_on = { offset, freq, positioned ? (guint32)offset : self->note_count++ };
+    self->note = note;
+    btedb_kick_note_on(&self->dsp, p, freq, note_on.seed);
+    if (positioned)
+      note_history_push(self, &note_on);
+  }
 
-    if (self->retrig_count > 0) {
-      self->retrig_period_cur -= timedelta;
-      if (self->retrig_period_cur <= 0) {
-        btedb_kickv_note_on(self, -self->retrig_period_cur, --self->retrig_count);
-        self->retrig_period_cur = self->c_retrigger_period;
-      }
-    }
-    
-    outbuf[i] *= lerp(0, self->volume, self->seconds / self->anticlick);
-    
-    self->seconds += timedelta;
+  // Automated values may wake the voice part way through the block, so it isn't known to stay idle.
+  const gboolean automated = controlled && !params;
+  if (!*mixing && (automated || !btedb_kick_is_idle(&self->dsp, p, rate))) {
+    memset(info->data, 0, requested_frames * sizeof(gfloat));
+    *mixing = TRUE;
   }
 
-  for (guint i = 0; i < 11; ++i)
-    self->accum[i] = fmod(self->accum[i], 2 * G_PI);
+  // Automation only applies to the voice's own parameters, not ones handed in.
+  if (automated)
+    return render_automated(self, p, GST_BUFFER_PTS(gstbuf), (gfloat*)info->data, requested_frames, rate);
+  
+  return btedb_kick_render(&self->dsp, p, (gfloat*)info->data, requested_frames, rate);
 }
 
 static const GstBtUiCustomGfxResponse* on_gfx_request(GstBtUiCustomGfx* iface) {
   BtEdbKickV* self = (BtEdbKickV*)iface;
+
+  BtEdbKickParams params;
+  btedb_kickv_get_params(self, &params);
+  const BtEdbKickParams* const p = &params;
   
   guint32* const gfx = self->gfx.data;
 
@@ -291,7 +500,7 @@ static const GstBtUiCustomGfxResponse* on_gfx_request(GstBtUiCustomGfx* iface) {
 
   // Show 0.5 seconds of the amplitude envelope.
   for (int i = 0; i < GFX_WIDTH; i++) {
-    const gfloat data = MIN(MAX(amp(self, (gfloat)i/GFX_WIDTH * 0.5), -1), 1);
+    const gfloat data = MIN(MAX(btedb_kick_amp(p, (gfloat)i/GFX_WIDTH * 0.5), -1), 1);
     const guint y0 = GFX_HEIGHT/2 - (GFX_HEIGHT/2 * data);
     const guint y1 = GFX_HEIGHT/2 + (GFX_HEIGHT/2 * data);
     for (int y = y0; y < y1; ++y) {
@@ -301,10 +510,10 @@ static const GstBtUiCustomGfxResponse* on_gfx_request(GstBtUiCustomGfx* iface) {
   }
 
   // Show 0.5 seconds of the frequency envelope (log graph)
-  gfloat data_ = MIN(MAX(freq(self, 0, 1, 0), -1), 1);
+  gfloat data_ = MIN(MAX(btedb_kick_freq(p, 0, 1, 0), -1), 1);
   for (int i = 0; i < GFX_WIDTH; i++) {
     const gfloat data = 0.2f +
-      MIN(MAX(logscale(10, 22050, 2, 10+freq(self, (gfloat)i/GFX_WIDTH * 0.5, 1, 0)*22040), 0), 1) * 0.8f;
+      MIN(MAX(logscale(10, 22050, 2, 10+btedb_kick_freq(p, (gfloat)i/GFX_WIDTH * 0.5, 1, 0)*22040), 0), 1) * 0.8f;
     
     const guint y0 = (GFX_HEIGHT-1) - (GFX_HEIGHT-1) * data_;
     const guint y1 = (GFX_HEIGHT-1) - (GFX_HEIGHT-1) * data;
@@ -318,56 +527,78 @@ static const GstBtUiCustomGfxResponse* on_gfx_request(GstBtUiCustomGfx* iface) {
   return &self->gfx;
 }
 
+// Hand a copy of the staged values to the streaming thread. Called with params_lock held.
+static void params_publish(BtEdbKickV* const self) {
+  self->params[self->params_back] = self->params_staged;
+  self->params_back = atomic_exchange(&self->params_middle, self->params_back | PARAMS_FRESH) & PARAMS_INDEX;
+}
+
 static void set_property(GObject* object, guint prop_id, const GValue* value, GParamSpec* pspec) {
   BtEdbKickV* self = (BtEdbKickV*)object;
 
   switch (prop_id) {
   case 1: {
+    // Notes are applied by the streaming thread at the start of the next block.
     GstBtNote note = g_value_get_enum(value);
-    if (note == GSTBT_NOTE_OFF) {
-      btedb_kickv_note_off(self, self->running_time);
-    } else if (note != GSTBT_NOTE_NONE) {
-      self->note = note;
-      btedb_kickv_note_on(self, 0, self->retrigger);
-    }
+    if (note != GSTBT_NOTE_NONE)
+      g_atomic_int_set(&self->note_pending, note);
     break;
   }
   default:
     g_assert(self->props);
-    btedb_properties_simple_set(self->props, pspec, value);
-
-    self->c_tone_start = powf(2, self->tone_start * 14.5);
-    self->c_tone_shape_a = 0.01 * powf(10, self->tone_shape_a * 3);
-    self->c_tone_shape_b = 0.01 * powf(10, self->tone_shape_b * 3);
-    self->c_tone_time = 0.001 * powf(10, self->tone_time * 4);
-    self->c_tone_shape_exp = 0.01 * powf(10, self->tone_shape_exp * 3);
-    self->c_amp_shape_a = 0.01 * powf(10, self->amp_shape_a * 3);
-    self->c_amp_shape_b = 0.01 * powf(10, self->amp_shape_b * 3);
-    self->c_amp_time = 0.001 * powf(10, self->amp_time * 4);
-    self->c_amp_shape_exp = 0.01 * powf(10, self->amp_shape_exp * 3);
-    self->c_overtone_vol_shape_a = 0.01 * powf(10, self->overtone_vol_shape_a * 3);
-    self->c_overtone_vol_shape_b = 0.01 * powf(10, self->overtone_vol_shape_b * 3);
-    self->c_overtone_vol_time = 0.001 * powf(10, self->overtone_vol_time * 4);
-    self->c_overtone_vol_shape_exp = 0.01 * powf(10, self->overtone_vol_shape_exp * 3);
-    self->c_noise_shape_a = 0.01 * powf(10, self->noise_shape_a * 3);
-    self->c_noise_shape_b = 0.01 * powf(10, self->noise_shape_b * 3);
-    self->c_noise_time = 0.001 * powf(10, self->noise_time * 4);
-    self->c_noise_shape_exp = 0.01 * powf(10, self->noise_shape_exp * 3);
-    self->c_retrigger_period = 0.001 * powf(10, self->retrigger_period * 3);
-  
-    g_signal_emit_by_name(self, "gstbt-ui-custom-gfx-invalidated", 0);
+    if (prop_id == prop_overtones_upper) {
+      // Gains missing from the array are zeroed, so setting an empty array silences the upper overtones.
+      const guint len = MIN(gst_value_array_get_size(value), OVERTONES_UPPER);
+      g_mutex_lock(&self->params_lock);
+      for (guint i = 0; i < OVERTONES_UPPER; ++i) {
+        self->params_staged.overtones[OVERTONES_SCALAR + i] =
+          i < len ? g_value_get_float(gst_value_array_get_value(value, i)) : 0;
+      }
+      btedb_kick_params_compile(&self->params_staged);
+      params_publish(self);
+      g_mutex_unlock(&self->params_lock);
+    } else if (g_atomic_pointer_get(&self->sync_thread) != g_thread_self() || !synced_set(self, pspec, value)) {
+      g_mutex_lock(&self->params_lock);
+      btedb_properties_simple_set(self->props, pspec, value);
+      btedb_kick_params_compile(&self->params_staged);
+      params_publish(self);
+      g_mutex_unlock(&self->params_lock);
+    }
+    if (self->gfx_invalidate)
+      btedb_gfx_invalidate_raise(self->gfx_invalidate);
   }
 }
 
 static void get_property(GObject* object, guint prop_id, GValue* value, GParamSpec* pspec) {
   BtEdbKickV* self = (BtEdbKickV*)object;
-  btedb_properties_simple_get(self->props, pspec, value);
+  g_mutex_lock(&self->params_lock);
+  if (prop_id == prop_overtones_upper) {
+    GValue gain = G_VALUE_INIT;
+    g_value_init(&gain, G_TYPE_FLOAT);
+    for (guint i = 0; i < OVERTONES_UPPER; ++i) {
+      g_value_set_float(&gain, self->params_staged.overtones[OVERTONES_SCALAR + i]);
+      gst_value_array_append_value(value, &gain);
+    }
+    g_value_unset(&gain);
+  } else {
+    btedb_properties_simple_get(self->props, pspec, value);
+  }
+  g_mutex_unlock(&self->params_lock);
 }
 
 static void dispose(GObject* object) {
   BtEdbKickV* self = (BtEdbKickV*)object;
-  btedb_properties_simple_free(self->props);
-  self->props = 0;
+  g_clear_pointer(&self->gfx_invalidate, g_source_unref);
+  g_clear_pointer(&self->props, btedb_properties_simple_free);
+  g_clear_pointer(&self->automatable, g_array_unref);
+  G_OBJECT_CLASS(btedb_kickv_parent_class)->dispose(object);
+}
+
+static void finalize(GObject* object) {
+  BtEdbKickV* self = (BtEdbKickV*)object;
+  btedb_resources_unref(self->resources);
+  g_mutex_clear(&self->params_lock);
+  G_OBJECT_CLASS(btedb_kickv_parent_class)->finalize(object);
 }
 
 static void btedb_kickv_class_init(BtEdbKickVClass* const klass) {
@@ -376,6 +607,7 @@ static void btedb_kickv_class_init(BtEdbKickVClass* const klass) {
     aclass->set_property = set_property;
     aclass->get_property = get_property;
     aclass->dispose = dispose;
+    aclass->finalize = finalize;
 
     // Note: variables will not be set to default values unless G_PARAM_CONSTRUCT is given.
     const GParamFlags flags =
@@ -446,7 +678,7 @@ static void btedb_kickv_class_init(BtEdbKickVClass* const klass) {
     g_object_class_install_property(
       aclass, idx++,
       g_param_spec_float("noise-octaves", "Noise Oct.", "Noise Octaves", 1.99999,
-                         PINK_NOISE_OCTAVES+0.99999, 4, flags));
+                         BTEDB_KICK_PINK_NOISE_OCTAVES+0.99999, 4, flags));
     
     g_object_class_install_property(
       aclass, idx++,
@@ -494,88 +726,118 @@ static void btedb_kickv_class_init(BtEdbKickVClass* const klass) {
     
     g_object_class_install_property(
       aclass, idx++,
-      g_param_spec_float("overtone0", "Otone 0", "Overtone 0", -1, 1, 0, flags));
-    g_object_class_install_property(
-      aclass, idx++,
-      g_param_spec_float("overtone1", "Otone 1", "Overtone 1", -1, 1, 0, flags));
-    g_object_class_install_property(
-      aclass, idx++,
-      g_param_spec_float("overtone2", "Otone 2", "Overtone 2", -1, 1, 0, flags));
-    g_object_class_install_property(
-      aclass, idx++,
-      g_param_spec_float("overtone3", "Otone 3", "Overtone 3", -1, 1, 0, flags));
-    g_object_class_install_property(
-      aclass, idx++,
-      g_param_spec_float("overtone4", "Otone 4", "Overtone 4", -1, 1, 0, flags));
-    g_object_class_install_property(
-      aclass, idx++,
-      g_param_spec_float("overtone5", "Otone 5", "Overtone 5", -1, 1, 0, flags));
-    g_object_class_install_property(
-      aclass, idx++,
-      g_param_spec_float("overtone6", "Otone 6", "Overtone 6", -1, 1, 0, flags));
+      g_param_spec_uint("partials", "Partials", "Overtones Rendered", 0, BTEDB_KICK_OVERTONES, 10, flags));
+
+    // Names are interned, so they last as long as the class does.
+    for (guint i = 0; i < OVERTONES_SCALAR; ++i) {
+      gchar name[16];
+      gchar nick[16];
+      gchar blurb[16];
+      g_snprintf(name, sizeof(name), "overtone%u", i);
+      g_snprintf(nick, sizeof(nick), "Otone %u", i);
+      g_snprintf(blurb, sizeof(blurb), "Overtone %u", i);
+      
+      g_object_class_install_property(
+        aclass, idx++,
+        g_param_spec_float(g_intern_string(name), g_intern_string(nick), g_intern_string(blurb), -1, 1, 0, flags));
+    }
+    
+    prop_overtones_upper = idx++;
+    g_object_class_install_property(
+      aclass, prop_overtones_upper,
+      gst_param_spec_array(
+        "overtones-upper", "Upper Otones", "Gains of the overtones after overtone9",
+        g_param_spec_float("overtone", "Overtone", "Overtone Gain", -1, 1, 0,
+                           (GParamFlags)(G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)),
+        (GParamFlags)(flags & ~GST_PARAM_CONTROLLABLE)));
+    
     g_object_class_install_property(
       aclass, idx++,
-      g_param_spec_float("overtone7", "Otone 7", "Overtone 7", -1, 1, 0, flags));
+      g_param_spec_float("anticlick", "Anticlick", "Anticlick", FLT_MIN, 0.1, 0.0004, flags));
+
+    // Levels of the last rendered block, for driving ducking and the like without analysing the output.
+    const GParamFlags flags_level = (GParamFlags)(G_PARAM_READABLE | G_PARAM_STATIC_STRINGS);
+    
     g_object_class_install_property(
       aclass, idx++,
-      g_param_spec_float("overtone8", "Otone 8", "Overtone 8", -1, 1, 0, flags));
+      g_param_spec_float("envelope", "Envelope", "Amplitude envelope peak", 0, G_MAXFLOAT, 0, flags_level));
     g_object_class_install_property(
       aclass, idx++,
-      g_param_spec_float("overtone9", "Otone 9", "Overtone 9", -1, 1, 0, flags));
+      g_param_spec_float("peak", "Peak", "Output peak", 0, G_MAXFLOAT, 0, flags_level));
     g_object_class_install_property(
       aclass, idx++,
-      g_param_spec_float("anticlick", "Anticlick", "Anticlick", FLT_MIN, 0.1, 0.0004, flags));
+      g_param_spec_float("rms", "RMS", "Output RMS", 0, G_MAXFLOAT, 0, flags_level));
   }
 }
 
 static void btedb_kickv_init(BtEdbKickV* const self) {
+  g_mutex_init(&self->params_lock);
+  self->params_back = 0;
+  self->params_middle = 1;
+  self->params_front = 2;
+  self->note_pending = GSTBT_NOTE_NONE;
+  
   self->props = btedb_properties_simple_new((GObject*)self);
-  btedb_properties_simple_add(self->props, "tone-start", &self->tone_start);
-  btedb_properties_simple_add(self->props, "tone-time", &self->tone_time);
-  btedb_properties_simple_add(self->props, "tone-shape-a", &self->tone_shape_a);
-  btedb_properties_simple_add(self->props, "tone-shape-b", &self->tone_shape_b);
-  btedb_properties_simple_add(self->props, "tone-shape-exp", &self->tone_shape_exp);
-  btedb_properties_simple_add(self->props, "amp-time", &self->amp_time);
-  btedb_properties_simple_add(self->props, "amp-shape-a", &self->amp_shape_a);
-  btedb_properties_simple_add(self->props, "amp-shape-b", &self->amp_shape_b);
-  btedb_properties_simple_add(self->props, "amp-shape-exp", &self->amp_shape_exp);
-  btedb_properties_simple_add(self->props, "tune", &self->tune);
-  btedb_properties_simple_add(self->props, "noise-vol", &self->noise_vol);
-  btedb_properties_simple_add(self->props, "noise-octaves", &self->noise_octaves);
-  btedb_properties_simple_add(self->props, "noise-time", &self->noise_time);
-  btedb_properties_simple_add(self->props, "noise-shape-a", &self->noise_shape_a);
-  btedb_properties_simple_add(self->props, "noise-shape-b", &self->noise_shape_b);
-  btedb_properties_simple_add(self->props, "noise-shape-exp", &self->noise_shape_exp);
-  btedb_properties_simple_add(self->props, "fundamental-vol", &self->fundamental_vol);
-  btedb_properties_simple_add(self->props, "overtone-vol", &self->overtone_vol);
-  btedb_properties_simple_add(self->props, "overtone-vol-time", &self->overtone_vol_time);
-  btedb_properties_simple_add(self->props, "overtone-vol-shape-a", &self->overtone_vol_shape_a);
-  btedb_properties_simple_add(self->props, "overtone-vol-shape-b", &self->overtone_vol_shape_b);
-  btedb_properties_simple_add(self->props, "overtone-vol-shape-exp", &self->overtone_vol_shape_exp);
-  btedb_properties_simple_add(self->props, "overtone-freq-factor", &self->overtone_freq_factor);
-  btedb_properties_simple_add(self->props, "overtone0", &self->overtone0);
-  btedb_properties_simple_add(self->props, "overtone1", &self->overtone1);
-  btedb_properties_simple_add(self->props, "overtone2", &self->overtone2);
-  btedb_properties_simple_add(self->props, "overtone3", &self->overtone3);
-  btedb_properties_simple_add(self->props, "overtone4", &self->overtone4);
-  btedb_properties_simple_add(self->props, "overtone5", &self->overtone5);
-  btedb_properties_simple_add(self->props, "overtone6", &self->overtone6);
-  btedb_properties_simple_add(self->props, "overtone7", &self->overtone7);
-  btedb_properties_simple_add(self->props, "overtone8", &self->overtone8);
-  btedb_properties_simple_add(self->props, "overtone9", &self->overtone9);
-  btedb_properties_simple_add(self->props, "volume", &self->volume);
-  btedb_properties_simple_add(self->props, "retrigger", &self->retrigger);
-  btedb_properties_simple_add(self->props, "retrigger-period", &self->retrigger_period);
-  btedb_properties_simple_add(self->props, "anticlick", &self->anticlick);
-
-  self->tones = gstbt_tone_conversion_new(GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT);
-  self->seconds = 3600;
-
-  for (guint i = 0; i < PINK_NOISE_OCTAVES; ++i)
-    self->lcg_state[i] = i;
+  btedb_properties_simple_add(self->props, "tone-start", &self->params_staged.tone_start);
+  btedb_properties_simple_add(self->props, "tone-time", &self->params_staged.tone_time);
+  btedb_properties_simple_add(self->props, "tone-shape-a", &self->params_staged.tone_shape_a);
+  btedb_properties_simple_add(self->props, "tone-shape-b", &self->params_staged.tone_shape_b);
+  btedb_properties_simple_add(self->props, "tone-shape-exp", &self->params_staged.tone_shape_exp);
+  btedb_properties_simple_add(self->props, "amp-time", &self->params_staged.amp_time);
+  btedb_properties_simple_add(self->props, "amp-shape-a", &self->params_staged.amp_shape_a);
+  btedb_properties_simple_add(self->props, "amp-shape-b", &self->params_staged.amp_shape_b);
+  btedb_properties_simple_add(self->props, "amp-shape-exp", &self->params_staged.amp_shape_exp);
+  btedb_properties_simple_add(self->props, "tune", &self->params_staged.tune);
+  btedb_properties_simple_add(self->props, "noise-vol", &self->params_staged.noise_vol);
+  btedb_properties_simple_add(self->props, "noise-octaves", &self->params_staged.noise_octaves);
+  btedb_properties_simple_add(self->props, "noise-time", &self->params_staged.noise_time);
+  btedb_properties_simple_add(self->props, "noise-shape-a", &self->params_staged.noise_shape_a);
+  btedb_properties_simple_add(self->props, "noise-shape-b", &self->params_staged.noise_shape_b);
+  btedb_properties_simple_add(self->props, "noise-shape-exp", &self->params_staged.noise_shape_exp);
+  btedb_properties_simple_add(self->props, "fundamental-vol", &self->params_staged.fundamental_vol);
+  btedb_properties_simple_add(self->props, "overtone-vol", &self->params_staged.overtone_vol);
+  btedb_properties_simple_add(self->props, "overtone-vol-time", &self->params_staged.overtone_vol_time);
+  btedb_properties_simple_add(self->props, "overtone-vol-shape-a", &self->params_staged.overtone_vol_shape_a);
+  btedb_properties_simple_add(self->props, "overtone-vol-shape-b", &self->params_staged.overtone_vol_shape_b);
+  btedb_properties_simple_add(self->props, "overtone-vol-shape-exp", &self->params_staged.overtone_vol_shape_exp);
+  btedb_properties_simple_add(self->props, "overtone-freq-factor", &self->params_staged.overtone_freq_factor);
+  btedb_properties_simple_add(self->props, "partials", &self->params_staged.partials);
+  
+  for (guint i = 0; i < OVERTONES_SCALAR; ++i) {
+    gchar name[16];
+    g_snprintf(name, sizeof(name), "overtone%u", i);
+    btedb_properties_simple_add(self->props, name, &self->params_staged.overtones[i]);
+  }
+  
+  btedb_properties_simple_add(self->props, "volume", &self->params_staged.volume);
+  btedb_properties_simple_add(self->props, "retrigger", &self->params_staged.retrigger);
+  btedb_properties_simple_add(self->props, "retrigger-period", &self->params_staged.retrigger_period);
+  btedb_properties_simple_add(self->props, "anticlick", &self->params_staged.anticlick);
+  btedb_properties_simple_add(self->props, "envelope", &self->dsp.levels.envelope);
+  btedb_properties_simple_add(self->props, "peak", &self->dsp.levels.peak);
+  btedb_properties_simple_add(self->props, "rms", &self->dsp.levels.rms);
+
+  // Controllable float properties that live in the parameter set can be followed in control steps.
+  self->automatable = g_array_new(FALSE, FALSE, sizeof(Automatable));
+  guint n_pspecs;
+  GParamSpec** const pspecs = g_object_class_list_properties(G_OBJECT_GET_CLASS(self), &n_pspecs);
+  for (guint i = 0; i < n_pspecs; ++i) {
+    const gchar* const var = btedb_properties_simple_get_var(self->props, pspecs[i]);
+    if (pspecs[i]->value_type != G_TYPE_FLOAT || !(pspecs[i]->flags & GST_PARAM_CONTROLLABLE) ||
+        var < (const gchar*)&self->params_staged || var >= (const gchar*)(&self->params_staged + 1))
+      continue;
+    
+    const Automatable a = { pspecs[i], var - (const gchar*)&self->params_staged };
+    g_array_append_val(self->automatable, a);
+  }
+  self->bound_scan_due = TRUE;
+  g_free(pspecs);
+
+  self->resources = btedb_resources_ref();
+  self->note_freqs = btedb_resources_get_note_freqs(self->resources, GSTBT_TONE_CONVERSION_EQUAL_TEMPERAMENT);
+  btedb_kick_state_init(&self->dsp, btedb_resources_get_sine(self->resources));
 
   self->gfx = (struct GstBtUiCustomGfxResponse){0, GFX_WIDTH, GFX_HEIGHT, self->gfx_data};
-  self->pink_accum = 1;
 }
 
 static void gstbt_ui_custom_gfx_interface_init(GstBtUiCustomGfxInterface *iface)
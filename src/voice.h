@@ -18,10 +18,38 @@
 
 #pragma once
 
+#include "src/core.h"
 #include <glib-object.h>
 #include <gst/gst.h>
 
+/*
+  Parameter sets (BtEdbKickParams, from the DSP core) are everything the streaming thread reads while rendering.
+
+  Writers (UI, controllers, preset loading) update a staged copy under a lock and publish it whole. The streaming
+  thread picks up the newest published copy at the start of each block, so it never sees a partially updated set
+  and never blocks on a writer.
+
+  Sets can also be captured and stored by the machine, then handed to btedb_kickv_process in place of the voice's
+  own.
+*/
+
 G_DECLARE_FINAL_TYPE(BtEdbKickV, btedb_kickv, BTEDB, KICKV, GstObject);
 
-void btedb_kickv_process(BtEdbKickV* self, GstBuffer* gstbuf, GstMapInfo* info, GstClockTime running_time,
-  guint requested_frames, guint rate);
+// Mix a block of the voice into the buffer. If 'params' is given, it's rendered with in place of the voice's own
+// property values. '*mixing' is TRUE if the buffer already holds output to mix into; if not, the voice clears it
+// before writing and sets '*mixing'.
+//
+// Returns FALSE if the voice was silent for the whole block, in which case the buffer is left untouched.
+gboolean btedb_kickv_process(BtEdbKickV* self, GstBuffer* gstbuf, GstMapInfo* info, GstClockTime running_time,
+  guint requested_frames, guint rate, const BtEdbKickParams* params, gboolean* mixing);
+
+// Levels of the last block rendered by btedb_kickv_process.
+void btedb_kickv_get_levels(BtEdbKickV* self, BtEdbKickLevels* levels);
+
+// Copy the voice's current property values and derived coefficients.
+void btedb_kickv_get_params(BtEdbKickV* self, BtEdbKickParams* params);
+
+
+// Raise 'source', from btedb_gfx_invalidate_new, whenever a property changes; the voice takes a reference. Call
+// before the voice is in use. Voices with no source don't report changes to their graphics.
+void btedb_kickv_set_gfx_invalidate(BtEdbKickV* self, GSource* source);
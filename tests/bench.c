@@ -0,0 +1,154 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+  Times btedb_kick_render on its own, for a kick struck twice a second.
+
+    bench [rate [seconds]]
+
+  First at a range of block sizes, reporting the cost per call and per sample; the difference between small and large
+  blocks is the fixed cost per call.
+
+  Then at a range of partial counts, against the same voice with no partials of its own plus that many overtones
+  rendered the way they were before the phasor bank, one table lookup per overtone per sample.
+*/
+
+// For clock_gettime under strict ISO C.
+#define _POSIX_C_SOURCE 199309L
+
+#include "src/core.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define BLOCK_MAX 4096
+#define SWEEP_FRAMES 256
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The element's property defaults, with some noise and overtones so that every part of the engine is exercised.
+static void params_init(BtEdbKickParams* p, unsigned partials) {
+  *p = (BtEdbKickParams){0};
+  p->tone_start = 0.55f;
+  p->tone_shape_a = 0.5f;
+  p->tone_shape_b = 0.5f;
+  p->tone_shape_exp = 0.672f;
+  p->amp_time = 0.3f;
+  p->amp_shape_a = 0.5f;
+  p->amp_shape_b = 0.5f;
+  p->amp_shape_exp = 0.672f;
+  p->noise_vol = 0.5f;
+  p->noise_octaves = 4;
+  p->noise_shape_b = 0.5f;
+  p->noise_shape_exp = 0.672f;
+  p->fundamental_vol = 1;
+  p->overtone_vol = 0.5f;
+  p->overtone_vol_time = 0.5f;
+  p->overtone_vol_shape_a = 0.5f;
+  p->overtone_vol_shape_b = 0.5f;
+  p->overtone_freq_factor = 2;
+  p->volume = 1;
+  p->anticlick = 0.0004f;
+  p->partials = partials;
+  for (unsigned i = 0; i < BTEDB_KICK_OVERTONES; ++i)
+    p->overtones[i] = 0.5f / (i + 1);
+  btedb_kick_params_compile(p);
+}
+
+// Mix 'count' table oscillators into 'out', as overtones at 'freq' and the bench's overtone frequency factor.
+static void table_oscillators(const float* sine, float* phases, unsigned count, float freq, float* out,
+                              unsigned frames, unsigned rate) {
+  for (unsigned j = 0; j < count; ++j) {
+    const float step = (float)(2 * BTEDB_KICK_PI) * freq * ((j+1) * 2 + 1) / rate;
+    const float vol = 0.5f / (j + 1);
+    float phase = phases[j];
+    for (unsigned i = 0; i < frames; ++i) {
+      out[i] += btedb_kick_sine(sine, phase) * vol;
+      phase += step;
+      if (phase >= (float)(2 * BTEDB_KICK_PI))
+        phase -= (float)(2 * BTEDB_KICK_PI);
+    }
+    phases[j] = phase;
+  }
+}
+
+// Seconds spent rendering 'seconds' of audio in blocks of 'frames', plus 'table_partials' table oscillators for
+// each audible block.
+static double time_render(const float* sine, const BtEdbKickParams* p, unsigned frames, unsigned rate,
+                          double seconds, unsigned table_partials) {
+  static float out[BLOCK_MAX];
+  float phases[BTEDB_KICK_OVERTONES] = {0};
+  BtEdbKickState state;
+  btedb_kick_state_init(&state, sine);
+
+  const unsigned long calls = (unsigned long)(seconds * rate / frames);
+  const unsigned long note_calls = rate / 2 / frames + 1;
+  const double start = now();
+  
+  for (unsigned long call = 0; call < calls; ++call) {
+    if (call % note_calls == 0)
+      btedb_kick_note_on(&state, p, 55, (uint32_t)call);
+    if (btedb_kick_render(&state, p, out, frames, rate))
+      table_oscillators(sine, phases, table_partials, 55, out, frames, rate);
+  }
+
+  return now() - start;
+}
+
+int main(int argc, char** argv) {
+  const unsigned rate = argc > 1 ? (unsigned)atoi(argv[1]) : 44100;
+  const double seconds = argc > 2 ? atof(argv[2]) : 60;
+
+  static float sine[BTEDB_KICK_SINE_TABLE_SIZE + 1];
+  btedb_kick_sine_table_fill(sine);
+
+  BtEdbKickParams p;
+  params_init(&p, 10);
+  
+  printf("%u Hz, %g s of audio per block size, 10 partials\n", rate, seconds);
+  printf("%8s %12s %12s %10s\n", "frames", "ns/call", "ns/sample", "realtime");
+  for (unsigned frames = 32; frames <= BLOCK_MAX; frames *= 2) {
+    const double elapsed = time_render(sine, &p, frames, rate, seconds, 0);
+    const double calls = (double)(unsigned long)(seconds * rate / frames);
+    printf("%8u %12.1f %12.2f %9.0fx\n", frames, elapsed / calls * 1e9, elapsed / (calls * frames) * 1e9,
+           calls * frames / rate / elapsed);
+  }
+
+  // Both are timed over the same number of samples, so their costs per sample compare directly. Overtones in the
+  // phasor bank that are culled for being inaudible or above Nyquist cost nothing, which is part of the comparison.
+  const double samples = (double)(unsigned long)(seconds * rate / SWEEP_FRAMES) * SWEEP_FRAMES;
+  BtEdbKickParams none;
+  params_init(&none, 0);
+  
+  printf("\n%u-frame blocks, ns/sample\n", SWEEP_FRAMES);
+  printf("%8s %12s %12s\n", "partials", "phasor bank", "table");
+  static const unsigned sweep[] = { 0, 1, 2, 4, 8, 10, 16, 32, BTEDB_KICK_OVERTONES };
+  for (unsigned i = 0; i < sizeof(sweep) / sizeof(sweep[0]); ++i) {
+    const unsigned partials = sweep[i];
+    params_init(&p, partials);
+    const double bank = time_render(sine, &p, SWEEP_FRAMES, rate, seconds, 0);
+    const double table = time_render(sine, &none, SWEEP_FRAMES, rate, seconds, partials);
+    printf("%8u %12.2f %12.2f\n", partials, bank / samples * 1e9, table / samples * 1e9);
+  }
+
+  return 0;
+}
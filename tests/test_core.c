@@ -0,0 +1,201 @@
+/*
+  Kick generator for Buzztrax
+  Copyright (C) 2021 David Beswick
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+  Checks that the shortcuts the renderer takes don't change what it renders:
+
+  - the noise generators' jump ahead agrees with stepping them;
+  - decimated envelopes stay close to ones evaluated at every sample;
+  - notes picked up part way through with btedb_kick_note_seek agree with ones rendered from the start.
+
+  The core is included rather than linked, to reach its internals.
+*/
+
+#include "src/core.c"
+#include <stdio.h>
+#include <stdlib.h>
+
+#define BLOCK_FRAMES 256
+#define RENDER_SECONDS 1
+
+// Decimated output may differ from full rate output by this much of its peak (-70dB).
+#define DECIMATION_TOLERANCE 3.2e-4f
+
+// Output after a seek may differ from continuous output by this much of its peak (-66dB). Continuous rendering
+// accumulates phase in single precision, where a seek works it out in double, so they drift apart slowly over a note.
+#define SEEK_TOLERANCE 5e-4f
+
+static float sine[BTEDB_KICK_SINE_TABLE_SIZE + 1];
+static int failures;
+
+static void check(int ok, const char* what) {
+  if (!ok)
+    ++failures;
+  printf("%s: %s\n", ok ? "ok" : "FAIL", what);
+}
+
+// A kick with every part of the engine in use. 'retrigger' and 'noise_vol' vary between checks.
+static void params_init(BtEdbKickParams* p, unsigned retrigger, float noise_vol) {
+  *p = (BtEdbKickParams){0};
+  p->tone_start = 0.6f;
+  p->tone_time = 0.13f;
+  p->tone_shape_a = 0.16f;
+  p->tone_shape_b = 0.2f;
+  p->tone_shape_exp = 0.67f;
+  p->amp_time = 0.37f;
+  p->amp_shape_a = 0.56f;
+  p->amp_shape_b = 0.27f;
+  p->amp_shape_exp = 0.64f;
+  p->noise_vol = noise_vol;
+  p->noise_octaves = 8.5f;
+  p->noise_time = 0.05f;
+  p->noise_shape_b = 0.22f;
+  p->noise_shape_exp = 0.72f;
+  p->fundamental_vol = 1;
+  p->overtone_vol = 1;
+  p->overtone_vol_time = 0.3f;
+  p->overtone_vol_shape_a = 0.3f;
+  p->overtone_vol_shape_b = 0.3f;
+  p->overtone_vol_shape_exp = 0.5f;
+  p->overtone_freq_factor = 1.3f;
+  p->volume = 1;
+  p->anticlick = 0.0004f;
+  p->retrigger = retrigger;
+  p->retrigger_period = 0.2f;
+  p->partials = 10;
+  for (unsigned i = 0; i < p->partials; ++i)
+    p->overtones[i] = 0.3f / (i + 1);
+  btedb_kick_params_compile(p);
+}
+
+// Render 'frames' of a voice into 'out', in blocks.
+static void render(BtEdbKickState* state, const BtEdbKickParams* p, float* out, unsigned frames, unsigned rate) {
+  memset(out, 0, frames * sizeof(*out));
+  for (unsigned first = 0; first < frames; first += BLOCK_FRAMES) {
+    const unsigned n = frames - first < BLOCK_FRAMES ? frames - first : BLOCK_FRAMES;
+    btedb_kick_render(state, p, out + first, n, rate);
+  }
+}
+
+// The largest difference between two renders, relative to the first's peak.
+static float difference(const float* a, const float* b, unsigned frames) {
+  float peak = 0;
+  float diff = 0;
+  for (unsigned i = 0; i < frames; ++i) {
+    peak = fmaxf(peak, fabsf(a[i]));
+    diff = fmaxf(diff, fabsf(a[i] - b[i]));
+  }
+  return peak > 0 ? diff / peak : diff;
+}
+
+static void test_lcg_skip(void) {
+  static const uint64_t steps[] = { 0, 1, 2, 3, 17, 1000, 65536, 123457 };
+
+  for (uint32_t seed = 0; seed < 3; ++seed) {
+    const uint32_t start = seed * 2654435769u + 7;
+    uint32_t state = start;
+    uint64_t stepped = 0;
+    int ok = 1;
+
+    for (unsigned i = 0; i < sizeof(steps) / sizeof(steps[0]); ++i) {
+      while (stepped < steps[i]) {
+        lcg(&state);
+        ++stepped;
+      }
+      ok &= lcg_skip(start, steps[i]) == state;
+    }
+
+    char what[64];
+    snprintf(what, sizeof(what), "lcg_skip matches stepping, from %u", (unsigned)start);
+    check(ok, what);
+  }
+}
+
+static void test_decimation(unsigned rate, unsigned retrigger, float noise_vol) {
+  const unsigned frames = RENDER_SECONDS * rate;
+  float* const decimated = malloc(frames * sizeof(float));
+  float* const full = malloc(frames * sizeof(float));
+  BtEdbKickParams p;
+  params_init(&p, retrigger, noise_vol);
+
+  BtEdbKickState state;
+  btedb_kick_state_init(&state, sine);
+  btedb_kick_note_on(&state, &p, 55, 1);
+  render(&state, &p, decimated, frames, rate);
+
+  btedb_kick_state_init(&state, sine);
+  state.full_rate = 1;
+  btedb_kick_note_on(&state, &p, 55, 1);
+  render(&state, &p, full, frames, rate);
+
+  const float diff = difference(full, decimated, frames);
+  char what[128];
+  snprintf(what, sizeof(what), "decimated matches full rate at %u Hz, %u retriggers, noise %g (%.1f dB)",
+           rate, retrigger, noise_vol, 20 * log10f(fmaxf(diff, 1e-12f)));
+  check(diff < DECIMATION_TOLERANCE, what);
+
+  free(decimated);
+  free(full);
+}
+
+static void test_seek(unsigned rate, unsigned retrigger, float noise_vol) {
+  static const double positions[] = { 0.001, 0.0173, 0.1, 0.25, 0.4321 };
+  const unsigned frames = RENDER_SECONDS * rate;
+  const unsigned compared = 4096;
+  float* const continuous = malloc(frames * sizeof(float));
+  float sought[4096];
+  BtEdbKickParams p;
+  params_init(&p, retrigger, noise_vol);
+
+  BtEdbKickState state;
+  btedb_kick_state_init(&state, sine);
+  btedb_kick_note_on(&state, &p, 55, 9);
+  render(&state, &p, continuous, frames, rate);
+
+  for (unsigned i = 0; i < sizeof(positions) / sizeof(positions[0]); ++i) {
+    // Seeks land on whole samples, as they do after a seek in the stream.
+    const unsigned offset = (unsigned)(positions[i] * rate);
+    btedb_kick_state_init(&state, sine);
+    btedb_kick_note_seek(&state, &p, 55, 9, (double)offset / rate, rate);
+    render(&state, &p, sought, compared, rate);
+
+    const float diff = difference(continuous + offset, sought, compared);
+    char what[128];
+    snprintf(what, sizeof(what), "seek to %u matches continuous at %u Hz, %u retriggers, noise %g (%.1f dB)",
+             offset, rate, retrigger, noise_vol, 20 * log10f(fmaxf(diff, 1e-12f)));
+    check(diff < SEEK_TOLERANCE, what);
+  }
+
+  free(continuous);
+}
+
+int main(void) {
+  static const unsigned rates[] = { 44100, 96000, 192000 };
+  btedb_kick_sine_table_fill(sine);
+
+  test_lcg_skip();
+
+  for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); ++i) {
+    test_decimation(rates[i], 0, 0);
+    test_decimation(rates[i], 2, 0.5f);
+    test_seek(rates[i], 0, 0);
+    test_seek(rates[i], 2, 0.5f);
+  }
+
+  return failures ? 1 : 0;
+}